@@ -11,11 +11,40 @@
  * 
 */
 
+#define _POSIX_C_SOURCE 200809L
+
 #include <stdio.h>
 #include <getopt.h>
 #include <unistd.h> 
 #include <stdlib.h>
 #include <string.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdint.h>
+#include <ctype.h>
+#include <limits.h>
+#include <time.h>
+#include <math.h>
+
+// Relaxed atomic updates of the progress counters, which the engine threads update while the sampler
+// reads them: they only have to be exact eventually. Without atomics a lock keeps them exact
+#if defined(__GNUC__)
+#define PROGRESS_LONG long
+#define PROGRESS_ADD(counter, amount) __atomic_fetch_add(&(counter), (amount), __ATOMIC_RELAXED)
+#define PROGRESS_SET(counter, value) __atomic_store_n(&(counter), (value), __ATOMIC_RELAXED)
+#define PROGRESS_GET(counter) __atomic_load_n(&(counter), __ATOMIC_RELAXED)
+#elif defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L && !defined(__STDC_NO_ATOMICS__)
+#include <stdatomic.h>
+#define PROGRESS_LONG _Atomic long
+#define PROGRESS_ADD(counter, amount) atomic_fetch_add_explicit(&(counter), (amount), memory_order_relaxed)
+#define PROGRESS_SET(counter, value) atomic_store_explicit(&(counter), (value), memory_order_relaxed)
+#define PROGRESS_GET(counter) atomic_load_explicit(&(counter), memory_order_relaxed)
+#else
+#define PROGRESS_LONG long
+#define PROGRESS_ADD(counter, amount) progressAdd(&(counter), (amount))
+#define PROGRESS_SET(counter, value) progressSet(&(counter), (value))
+#define PROGRESS_GET(counter) progressAdd(&(counter), 0)
+#endif
 
 /**
  * @brief This function serves as the entry point for the program. It uses the getopt library with
@@ -28,26 +57,40 @@
 void run(int argc, char *argv[]);
 
 /**
- * @brief Dynamically allocates memory to create a square matrix and initializes all elements to zero.
+ * @brief First pass over the command-line arguments. It only records the settings that modify
+ * the way the implementations behave (such as `--shards`), so that they apply no matter
+ * where they appear on the command line. The implementations themselves are run by `run`.
+ *
+ * @param argc The number of command-line arguments.
+ * @param argv An array of strings representing the command-line arguments.
+*/
+void parseSettings(int argc, char *argv[]);
+
+/**
+ * @brief Dynamically allocates memory to create a matrix and initializes all elements to zero.
  * 
- * This function allocates memory to create a square matrix of size N x N, where N is the number
+ * This function allocates memory to create a matrix of size rows x N, where N is the number
  * of cities in the adjacency matrix. Each element of the matrix is initialized to zero, 
  * whereas the matrix is represented as a two-dimensional array of integers.
  * 
+ * @param rows The number of rows to allocate (N for a full square matrix).
  * @return A pointer to the dynamically allocated 2D integer matrix, where each element is initialized to zero.
  */
-int** createMatrix();
+int** createMatrix(int rows);
 
 /**
  * @brief Frees the memory allocated for a two-dimensional integer matrix.
  * @param matrix A pointer to the two-dimensional integer matrix to be deallocated.
+ * @param rows The number of rows the matrix was created with.
  * 
 */
-void freeMatrix(int **matrix);
+void freeMatrix(int **matrix, int rows);
 
 /**
  * @brief This function reads the adjacency matrix data from the provided input file and initializes
  * the city matrix used for graph representation. It also performs error checking for file reading.
+ * The number of cities may be followed by a token naming the encoding of the rows ("bits", "hex"
+ * or "rle"); without it the rows are numbers separated by spaces.
  *
  * @param inputFile A pointer to the input file from which the adjacency matrix data is read.
  * 
@@ -55,17 +98,287 @@ void freeMatrix(int **matrix);
 void readAdjacencyMatrix(FILE *inputFile);
 
 /**
- * @brief Recursive function to find a path from a given source city to a 
- * given destination city and print the path if it exists.
+ * @brief Opens, reads and closes the input file, unless the same file is already loaded, so that
+ * a large network is only parsed once for all the options. With --stats it then prints the
+ * size of the network and of its storage.
+ *
+ * @param filename The name of the input file.
+*/
+void loadGraph(const char *filename);
+
+/**
+ * @brief Frees the city matrix and the adjacency lists of the loaded network.
+*/
+void freeGraph(void);
+
+// The encodings of the rows of an adjacency matrix file; "edges" lists the connections instead of
+// rows, and "weighted" lists them with their costs
+enum { ENC_PLAIN, ENC_BITS, ENC_HEX, ENC_RLE, ENC_EDGES, ENC_WEIGHTED };
+
+/**
+ * @brief Reads a network given as a list of connections "<source> <destination>" up to the end of
+ * the file and stores it as adjacency lists only, without an N x N matrix, so that networks of
+ * millions of cities fit in memory.
+ *
+ * @param inputFile The file the connections are read from.
+ * @param weighted Whether every connection is followed by its cost, "<source> <destination> <cost>".
+*/
+void readEdgeList(FILE *inputFile, int weighted);
+
+/**
+ * @brief Builds the adjacency lists (CSR: rowStart and adjacency) from a list of connections.
+ * The neighbors of every city are sorted and repeated connections are dropped, keeping the
+ * cheapest one.
+ *
+ * @param from The source city of every connection.
+ * @param to The destination city of every connection.
+ * @param cost The cost of every connection, or NULL when they all cost 1.
+ * @param count The number of connections.
+*/
+void buildGraph(const int *from, const int *to, const int *cost, long count);
+
+/**
+ * @brief Compares two cities for qsort, in ascending order.
+ *
+ * @param a The first city.
+ * @param b The second city.
+ * @return A negative number, zero or a positive number.
+*/
+int compareCities(const void *a, const void *b);
+
+/**
+ * @brief Builds the adjacency lists of the reversed network, with a connection v -> u of the
+ * same cost for every connection u -> v, for the searches towards a city.
+ *
+ * @param reverseStart Set to the row offsets of the reversed network.
+ * @param reverseAdjacency Set to the neighbors of the reversed network.
+ * @param reverseWeight Set to the costs of the reversed network, or NULL when they all cost 1.
+*/
+void buildReverse(long **reverseStart, int **reverseAdjacency, int **reverseWeight);
+
+/**
+ * @brief Finds the cost of a connection: its weight, or 1 when the network has no weights or
+ * --hops is given.
+ *
+ * @param costs The weights of the connections, or NULL.
+ * @param e The index of the connection.
+ * @return The cost.
+*/
+int linkCost(const int *costs, long e);
+
+// An entry of the priority queue of the weighted searches
+typedef struct {
+    long long distance; // The cost of the route to the city
+    int city; // The city
+    int tag; // What the route belongs to, such as the facility it starts from
+} HeapItem;
+
+// A binary heap of HeapItems, the smallest distance first and then the smallest tag and city
+typedef struct {
+    HeapItem *items; // The entries
+    long size; // The number of entries
+    long capacity; // The number of entries there is room for
+} Heap;
+
+/**
+ * @brief Adds an entry to a heap.
+ *
+ * @param heap The heap, all zeros when empty.
+ * @param distance The cost of the route to the city.
+ * @param city The city.
+ * @param tag What the route belongs to.
+*/
+void heapPush(Heap *heap, long long distance, int city, int tag);
+
+/**
+ * @brief Removes the first entry of a heap: the smallest distance, then the smallest tag, then
+ * the smallest city, so that the searches break ties the same way every time.
+ *
+ * @param heap The heap.
+ * @param item Set to the entry.
+ * @return 1 if there was an entry, 0 if the heap is empty.
+*/
+int heapPop(Heap *heap, HeapItem *item);
+
+/**
+ * @brief Adds the connections of a row of the matrix to the adjacency lists, a connection for
+ * every nonzero cell. The rows are added in order while they are read.
+ *
+ * @param city The city of the row.
+ * @param row The row of the matrix.
+ * @param capacity The number of connections the adjacency array has room for, updated when it grows.
+*/
+void appendRow(int city, const int *row, long *capacity);
+
+/**
+ * @brief Stops the program with a clear message when a structure about to be allocated would
+ * exceed the --mem-limit, instead of letting the system kill it halfway through.
+ *
+ * @param bytes The total number of bytes needed.
+ * @param what A description of what needs the memory.
+*/
+void checkMemory(size_t bytes, const char *what);
+
+/**
+ * @brief Starts the --time-limit of a command; every -r, -p and -o gets the whole limit.
+*/
+void startDeadline(void);
+
+/**
+ * @brief Checks whether the --time-limit of the current command has passed. The closure engines
+ * call it between source cities and rounds and the path search every few thousand steps, so
+ * that they stop soon after the limit with what they have found so far.
+ *
+ * @return 1 when the limit has passed, 0 otherwise.
+*/
+int deadlinePassed(void);
+
+/**
+ * @brief Reports on stderr how far a command got when its --time-limit stopped it.
+ *
+ * @param what The partial result of the command.
+*/
+void reportDeadline(const char *what);
+
+/**
+ * @brief Fills a row of 0/1 cells from the adjacency list of a city.
+ *
+ * @param city The city.
+ * @param row The row to fill, of N cells.
+*/
+void expandRow(int city, int *row);
+
+/**
+ * @brief Prints the --stats report of the loaded network to stderr: the number of cities and
+ * connections, the memory of the adjacency lists and matrix with the bytes per connection,
+ * and the strongly connected components.
+*/
+void printGraphStats(void);
+
+/**
+ * @brief Finds the strongly connected components of the network with an iterative version of
+ * Tarjan's algorithm, so that the depth of the search is not limited by the call stack. The
+ * components are numbered in the order they are completed, so a connection between two components
+ * always goes to the one with the smaller number.
+ *
+ * @param component Set to the component of every city.
+ * @return The number of strongly connected components.
+*/
+int findComponents(int *component);
+
+/**
+ * @brief Counts the strongly connected components of the network with findComponents.
+ *
+ * @param largest Set to the number of cities in the largest component.
+ * @return The number of strongly connected components.
+*/
+long countComponents(long *largest);
+
+/**
+ * @brief Finds the encoding with the given name.
+ *
+ * @param name The name of the encoding ("plain", "bits", "hex", "rle", "edges" or "weighted").
+ * @return The encoding, or -1 if there is no encoding with this name.
+*/
+int parseEncoding(const char *name);
+
+/**
+ * @brief Decodes a row written as a bit string ("01101"), one character per city. The characters
+ * are checked eight at a time as a single 64-bit word before being converted.
+ *
+ * @param text The characters of the row.
+ * @param length The number of characters in text.
+ * @param row The row of the matrix to fill.
+ * @return 0 on success, -1 if the row has the wrong length or a character other than 0 and 1.
+*/
+int decodeBitsRow(const char *text, size_t length, int *row);
+
+/**
+ * @brief Decodes a row written in hex, each digit holding 4 cities with the first city in its
+ * highest bit. The cities past N in the last digit must be 0.
+ *
+ * @param text The characters of the row.
+ * @param length The number of characters in text.
+ * @param row The row of the matrix to fill.
+ * @return 0 on success, -1 if the row has the wrong length or a character that is not a hex digit.
+*/
+int decodeHexRow(const char *text, size_t length, int *row);
+
+/**
+ * @brief Decodes a row written as run-length pairs "<value> <count>", the counts adding up to N.
+ *
+ * @param inputFile The file the pairs are read from.
+ * @param row The row of the matrix to fill.
+ * @return 0 on success, -1 if the pairs are missing or do not add up to N.
+*/
+int decodeRleRow(FILE *inputFile, int *row);
+
+/**
+ * @brief Writes the city matrix in the given encoding, in the format readAdjacencyMatrix reads.
+ *
+ * @param out The stream the matrix is written to.
+ * @param encoding The encoding of the rows.
+*/
+void writeEncodedMatrix(FILE *out, int encoding);
+
+/**
+ * @brief Function to find a path from a given source city to a given destination city
+ * and print the path if it exists. It is a depth first search over the adjacency lists with
+ * its own stack instead of recursion, and the visited cities kept as bits, so its size is
+ * only limited by memory. It finds the same path the recursive search did.
  * 
  * @param source The source city given by the user.
  * @param destination The destination city given by the user.
- * @param visited An array representing the visited cities.
- * @param path An array representing the current path needed to be printed.
- * @param pathIndex The index of the current path.
- * @return 1 if a path is found, 0 if no path exists.
+ * @return 1 if a path is found, 0 if no path exists, -1 if the --time-limit was reached first.
+ */
+int findPath(int source, int destination);
+
+/**
+ * @brief Chooses the direction of the next level of a breadth first search with the heuristic of
+ * Beamer: bottom-up once a growing frontier has more connections than 1/DIRECTION_ALPHA of those
+ * into the cities not reached yet, and top-down again once it has fewer than 1/DIRECTION_BETA of
+ * the cities.
+ *
+ * @param frontier The cities of the frontier.
+ * @param frontierSize The number of cities of the frontier.
+ * @param previousSize The number of cities of the level before.
+ * @param unexplored The number of connections into the cities not reached yet.
+ * @param bottomUp Whether the level before went bottom-up.
+ * @return 1 if the next level goes bottom-up, 0 if it goes top-down.
+*/
+int chooseDirection(const int *frontier, int frontierSize, int previousSize, long unexplored, int bottomUp);
+
+/**
+ * @brief Finds the next level of a breadth first search bottom-up: every city not reached yet
+ * goes through the connections into it, built by buildIncoming, for one from the frontier, which
+ * is kept as bits. The cities found come in ascending order, and each is reached from the smallest
+ * city of the frontier leading to it.
+ *
+ * @param frontier The cities of the frontier.
+ * @param frontierSize The number of cities of the frontier.
+ * @param seen The cities reached so far are those with seen[city] == mark.
+ * @param mark The mark of the cities reached.
+ * @param from Gets the city of the frontier every city found is reached from.
+ * @param next Gets the cities found.
+ * @param inFrontier Room for the bits of N cities, all clear, and clear again on return.
+ * @return The number of cities found.
+*/
+int bottomUpLevel(const int *frontier, int frontierSize, const int *seen, int mark, int *from, int *next,
+                  uint64_t *inFrontier);
+
+/**
+ * @brief Prints a route of fewest connections from the source city to the destination city, like
+ * findPath, for -r with --hops. It is a breadth first search that chooses the direction of every
+ * level with the heuristic of Beamer: top-down through the connections of the frontier while it is
+ * small, bottom-up through the connections into the cities not reached yet, looking for one in the
+ * frontier bits, once a growing frontier has more connections than 1/DIRECTION_ALPHA of theirs. With
+ * --stats it prints the direction and the size of the frontier of every level onto stderr.
+ *
+ * @param source The source city given by the user.
+ * @param destination The destination city given by the user.
+ * @return 1 if a path is found, 0 if no path exists, -1 if the --time-limit was reached first.
  */
-int findPath( int source, int destination, int *visited, int *path, int pathIndex);
+int findFewestHops(int source, int destination);
 
 /**
  * @brief This function calculates the transitive closure of a directed graph represented
@@ -75,318 +388,7612 @@ int findPath( int source, int destination, int *visited, int *path, int pathInde
  * @param cityMatrix A 2D integer array representing the adjacency matrix of the graph.
  * @param outputFile A pointer to the output file where the transitive closure is printed (use NULL for no file output).
  * @param printToFile An integer flag (0 or 1) indicating whether to print the closure to a file (1) or standard output (0).
+ * @return The number of pairs printed.
+*/
+long calculateTransitiveClosure(int **cityMatrix, FILE *outputFile, int printToFile);
+
+// Function called for every pair of the R* table with the round it was found in (0 for a direct connection)
+typedef void (*PairFunction)(void *context, int source, int destination, int round);
+
+/**
+ * @brief Calculates the transitive closure for the source cities first ... last-1 only and passes
+ * every pair found to the given function. The rows of the closure do not depend on each other, so
+ * any range of rows can be computed on its own. The pairs keep the order of the full R* table:
+ * the direct connections first, followed by the connections found in each round.
+ *
+ * @param cityMatrix A 2D integer array representing the adjacency matrix of the graph.
+ * @param first The first source city of the range.
+ * @param last One past the last source city of the range.
+ * @param emit The function called for every pair.
+ * @param context The first argument given to emit.
+ * @return The number of pairs found.
+*/
+long closeRows(int **cityMatrix, int first, int last, PairFunction emit, void *context);
+
+// The closure engines: rounds over the city matrix, a breadth first search per source city, rounds over bits,
+// or the chains of the condensed network, and the choice of the fastest one whatever its order of pairs
+enum { ENGINE_AUTO, ENGINE_ROUNDS, ENGINE_BFS, ENGINE_BITSET, ENGINE_CHAINS, ENGINE_FASTEST };
+
+/**
+ * @brief Calculates the transitive closure for the source cities first ... last-1 with a breadth
+ * first search from each source over the adjacency lists. It needs O(N) memory per thread
+ * instead of the N x N matrices of closeRows. The pairs of each row come in the same order as in
+ * closeRows, but the rows come one after another instead of round after round. When the
+ * connections into every city were built by planClosure, a round whose frontier has many
+ * connections goes bottom-up like findFewestHops, and its cities are sorted back into the order of
+ * the top-down round.
+ *
+ * @param first The first source city of the range.
+ * @param last One past the last source city of the range.
+ * @param emit The function called for every pair.
+ * @param context The first argument given to emit.
+ * @return The number of pairs found.
+*/
+long closeRowsBFS(int first, int last, PairFunction emit, void *context);
+
+/**
+ * @brief Calculates the transitive closure for the source cities first ... last-1 with the rounds
+ * of closeRows, keeping every row as bits. Each round ORs the bit rows of the adjacency matrix
+ * of the cities found in the previous round, 64 cities at a time, and the pairs come in exactly
+ * the order of closeRows with 1/32 of its memory.
+ *
+ * @param first The first source city of the range.
+ * @param last One past the last source city of the range.
+ * @param emit The function called for every pair.
+ * @param context The first argument given to emit.
+ * @return The number of pairs found.
+*/
+long closeRowsBits(int first, int last, PairFunction emit, void *context);
+
+/**
+ * @brief Covers the network condensed to its strongly connected components with chains, once per
+ * network: paths of components along connections, from a minimum path cover found by matching
+ * every component to the next one on its path with the Hopcroft-Karp algorithm. Every component
+ * reaches all the components after it on its chain.
+*/
+void buildChains(void);
+
+/**
+ * @brief Finds for every component the earliest position it reaches on every chain (Jagadish's
+ * compressed closure), once per network. The components are visited so that those they connect to
+ * come first, and a component takes the smallest position of each chain over its connections.
+*/
+void buildChainLabels(void);
+
+/**
+ * @brief Calculates the transitive closure for the source cities first ... last-1 from the chain
+ * labels: the cities reached from a source are the other cities of its component when they form a
+ * cycle, and the components from its position on every chain to the end of the chain. The pairs of
+ * each row come in ascending order, all with round 0.
+ *
+ * @param first The first source city of the range.
+ * @param last One past the last source city of the range.
+ * @param emit The function called for every pair.
+ * @param context The first argument given to emit.
+ * @return The number of pairs found.
+*/
+long closeRowsChains(int first, int last, PairFunction emit, void *context);
+
+/**
+ * @brief Finds the position of the lowest set bit of a word.
+ *
+ * @param bits The word, not zero.
+ * @return The position, 0 for the lowest bit.
+*/
+int lowestBit(uint64_t bits);
+
+/**
+ * @brief Counts the set bits of a word.
+ *
+ * @param bits The word.
+ * @return The number of set bits.
+*/
+int countBits(uint64_t bits);
+
+/**
+ * @brief Builds the adjacency matrix as rows of bits from the adjacency lists, once per network.
+*/
+void buildAdjacencyBits(void);
+
+/**
+ * @brief Builds the connections into every city, each list in ascending order, once per network,
+ * for the bottom-up rounds of the breadth first searches.
+*/
+void buildIncoming(void);
+
+/**
+ * @brief Prints how many rounds of the breadth first search engine went top-down and bottom-up at
+ * every level onto stderr, for --stats, and clears the counts.
+*/
+void reportDirections(void);
+
+/**
+ * @brief Measures the memory bandwidth the machine sustains, once, with the copy and triad
+ * kernels of STREAM over arrays much larger than the caches, and prints it on stderr.
+ *
+ * @return The best bandwidth in bytes per second.
+*/
+double memoryBandwidth(void);
+
+/**
+ * @brief Prints on stderr the bytes per second and word operations per second a round of the
+ * bitset engine achieved, and the bytes per second as a fraction of memoryBandwidth.
+ *
+ * @param first The first source city of the range.
+ * @param last One past the last source city of the range.
+ * @param round The round.
+ * @param bytes The bytes the round read and wrote.
+ * @param operations The words the round combined.
+ * @param start When the round started.
+*/
+void reportBandwidth(int first, int last, int round, double bytes, double operations, const struct timespec *start);
+
+/**
+ * @brief Implements the "--autotune" option: times the bitset engine and the search per source
+ * city on generated networks of several sizes and densities, and fits the time per reached city
+ * of each as a fixed cost, a cost per word of bits or per connection, and a cost growing with
+ * log2(N) for the caches and the sorted rounds of the search. The costs are saved as
+ * the tuning profile; later runs load it and planClosure uses it to choose between the two
+ * engines by their estimated time.
+*/
+void implementAutotune(void);
+
+/**
+ * @brief Finds the name of the tuning profile: $HOME/.cityLink.tune, or cityLink.tune in the
+ * current directory without a home directory.
+ *
+ * @return The name, to be freed.
+*/
+char *tuningPath(void);
+
+/**
+ * @brief Loads the tuning profile written by --autotune, once.
+ *
+ * @return 1 if the profile was loaded, 0 if there is none.
+*/
+int loadTuning(void);
+
+/**
+ * @brief A PairFunction that only counts, for timing the engines without any output.
+ *
+ * @param context Unused.
+ * @param source The source city.
+ * @param destination The destination city.
+ * @param round The round the pair was found in.
+*/
+void skipPair(void *context, int source, int destination, int round);
+
+/**
+ * @brief Finds the physical memory of the machine.
+ *
+ * @return The number of bytes, or the largest size when it is unknown.
+*/
+size_t physicalMemory(void);
+
+/**
+ * @brief Estimates the memory a closure engine needs on top of the loaded network.
+ *
+ * @param engine The engine.
+ * @param rows The number of source cities calculated.
+ * @param threads The number of threads calculating them.
+ * @return The estimated number of bytes.
+*/
+size_t engineBytes(int engine, int rows, int threads);
+
+/**
+ * @brief Chooses the closure engine before the R* table is calculated. An engine given with
+ * --engine is kept; otherwise the bitset engine is used when it fits in the --mem-limit (or in the
+ * physical memory), and the breadth first search per source city when it does not. With --engine
+ * fastest, which allows any order of the pairs, the chains engine is used first for a network of
+ * CHAIN_CITIES cities or more covered by at most N/64 chains, so that the labels of a city are no
+ * longer than a row of bits, and the tuning profile may prefer the search to the bitset engine.
+ * With --mem-limit the program stops with the estimate when the chosen engine does not fit.
+ *
+ * @param rows The number of source cities calculated.
+ * @param threads The number of threads calculating them.
+*/
+void planClosure(int rows, int threads);
+
+/**
+ * @brief Calculates the transitive closure for a range of source cities with the engine chosen
+ * by planClosure.
+ *
+ * @param cityMatrix A 2D integer array representing the adjacency matrix of the graph (NULL when only the adjacency lists are loaded).
+ * @param first The first source city of the range.
+ * @param last One past the last source city of the range.
+ * @param emit The function called for every pair.
+ * @param context The first argument given to emit.
+ * @return The number of pairs found.
+*/
+long closeRange(int **cityMatrix, int first, int last, PairFunction emit, void *context);
+
+/**
+ * @brief Prints a pair of the R* table as "source -> destination".
+ *
+ * @param context The stream the pair is printed to.
+ * @param source The source city.
+ * @param destination The destination city.
+ * @param round The round the pair was found in (not printed).
+*/
+void printPair(void *context, int source, int destination, int round);
+
+/**
+ * @brief Builds the name of an output file, "out-<filename>" followed by the given suffix.
+ *
+ * @param filename The name of the input file.
+ * @param suffix The text appended to the name (use "" for none).
+ * @return A dynamically allocated string which the caller must free.
+*/
+char *outputName(const char *filename, const char *suffix);
+
+/**
+ * @brief Writes the R* table as several shard files out-<filename>.000, out-<filename>.001, ...
+ * plus a manifest out-<filename>.manifest. Each shard holds a contiguous range of source cities
+ * and is calculated and written by its own thread, in the same order the pairs of these rows
+ * have in the single R* table.
+ *
+ * @param filename The name of the input file.
+ * @param shards The number of shard files to write.
+*/
+void writeShards(const char *filename, int shards);
+
+// An output file; when compressed, the text goes through a pipe to a compressor thread
+typedef struct {
+    FILE *stream; // The stream the text is written to
+    FILE *file; // The file on disk
+    FILE *pipe; // The read end of the pipe (NULL when the output is not compressed)
+    pthread_t thread; // The compressor thread
+} Output;
+
+/**
+ * @brief Opens an output file for writing. When the --compress option is given, the text written
+ * to the returned stream is compressed by a separate thread into a CLZ frame, so that the
+ * calculation and the compression run side by side.
+ *
+ * @param path The name of the output file.
+ * @return The opened output, to be closed with closeOutput.
+*/
+Output *openOutput(const char *path);
+
+/**
+ * @brief Flushes and closes an output opened with openOutput, waiting for the compressor
+ * thread to write the last block.
+ *
+ * @param output The output to close.
+*/
+void closeOutput(Output *output);
+
+/**
+ * @brief Builds the suffix of the name of an -o output file from the output settings:
+ * the shard number, ".arrows" for Arrow output and ".clz" for compressed output.
+ *
+ * @param suffix The buffer the suffix is written to.
+ * @param size The size of the buffer.
+ * @param shard The number of the shard, or -1 when the R* table is not sharded.
+*/
+void outputSuffix(char *suffix, size_t size, int shard);
+
+/**
+ * @brief Calculates the R* table rows first ... last-1 and writes them to an output, either as
+ * text or as an Arrow stream depending on the --arrow option.
+ *
+ * @param output The output the rows are written to.
+ * @param first The first source city of the range.
+ * @param last One past the last source city of the range.
+ * @return The number of pairs written.
 */
-void calculateTransitiveClosure(int **cityMatrix, FILE *outputFile, int printToFile);
+long writeClosure(Output *output, int first, int last);
+
+// Rows of a 0/1 matrix packed 8 cities per byte, the first city of a byte in its highest bit
+typedef struct {
+    unsigned char *bits; // The packed rows one after the other
+    size_t rowBytes; // The number of bytes of a row
+    int first; // The city of the first row
+} BitRows;
+
+/**
+ * @brief Packs a row of the city matrix into bits.
+ *
+ * @param row The row of the matrix.
+ * @param bits The buffer for the packed row, of (N + 7) / 8 bytes.
+ * @return 0 on success, -1 if the row has values other than 0 and 1.
+*/
+int packRow(const int *row, unsigned char *bits);
+
+/**
+ * @brief Writes a packed row as text "0 1 0 ...", turning each byte into its 8 cells at once
+ * with a precomputed byte-to-text table, and writing the whole row with a single call.
+ *
+ * @param out The stream the row is written to.
+ * @param bits The packed row.
+ * @param text A buffer of at least 2 * N + 1 characters.
+ * @param trailingSpace Whether the last cell is followed by a space, like in the neighbor table.
+*/
+void writeBitRow(FILE *out, const unsigned char *bits, char *text, int trailingSpace);
+
+/**
+ * @brief Sets the bit of a pair of the R* table in packed closure rows.
+ *
+ * @param context The BitRows.
+ * @param source The source city.
+ * @param destination The destination city.
+ * @param round The round the pair was found in (not used).
+*/
+void setPairBit(void *context, int source, int destination, int round);
+
+/**
+ * @brief Calculates the R* table rows first ... last-1 and writes them as rows of a 0/1 matrix
+ * (the --as-matrix option).
+ *
+ * @param out The stream the rows are written to.
+ * @param first The first source city of the range.
+ * @param last One past the last source city of the range.
+ * @return The number of pairs in the rows.
+*/
+long writeClosureMatrix(FILE *out, int first, int last);
+
+// An input file; when compressed, a decompressor thread feeds the text to the parser through a pipe
+typedef struct {
+    FILE *stream; // The stream the text is read from
+    FILE *file; // The file on disk
+    FILE *pipe; // The write end of the pipe (NULL when the file is not compressed)
+    pthread_t thread; // The decompressor thread
+    int version; // The version of the CLZ frame of a compressed file
+} Input;
+
+/**
+ * @brief Opens an input file for reading. A file starting with the CLZ magic is decompressed
+ * by a separate thread while it is being parsed, without any temporary file.
+ *
+ * @param filename The name of the input file.
+ * @return The opened input, to be closed with closeInput.
+*/
+Input *openInput(const char *filename);
+
+/**
+ * @brief Closes an input opened with openInput, waiting for the decompressor thread to stop.
+ *
+ * @param input The input to close.
+*/
+void closeInput(Input *input);
+
+/**
+ * @brief Writes a 4-byte little endian number, as used by the CLZ and Arrow formats.
+ *
+ * @param dst The buffer for the 4 bytes.
+ * @param value The number.
+*/
+void writeLE32(unsigned char *dst, unsigned long value);
+
+/**
+ * @brief Compresses one block with the LZ4-style encoding of the CLZ format. A block is a list
+ * of sequences, each one being a token byte (literal length in the high nibble, match length
+ * minus 4 in the low nibble, 15 meaning that more length bytes follow), the literals, and a
+ * 2-byte little endian offset back to the match. The last sequence has literals only.
+ *
+ * @param src The bytes to compress.
+ * @param size The number of bytes to compress (at most CLZ_BLOCK).
+ * @param dst The buffer for the compressed bytes, of at least CLZ_BOUND(size) bytes.
+ * @return The number of compressed bytes.
+*/
+int clzCompressBlock(const unsigned char *src, int size, unsigned char *dst);
+
+/**
+ * @brief Decompresses one block produced by clzCompressBlock.
+ *
+ * @param src The compressed bytes.
+ * @param size The number of compressed bytes.
+ * @param dst The buffer for the decompressed bytes.
+ * @param capacity The size of the dst buffer.
+ * @return The number of decompressed bytes, or -1 if the block is corrupt.
+*/
+int clzDecompressBlock(const unsigned char *src, int size, unsigned char *dst, int capacity);
+
+/**
+ * @brief Rewrites the lines "<source> -> <destination>" of a block, the pairs of the R* table, as
+ * varints: for each run of pairs of a source, its zigzag difference from the previous source, the
+ * number of pairs after the first, and its destinations, either as they are or as the zigzag
+ * difference from the previous destination, whichever is shorter for the block (rows found in
+ * discovery order have no useful differences, sorted rows do). The later stages compress these
+ * far better than the digits. The bytes up to the first newline (a header or the end of a line cut by
+ * the previous block) are kept as they are, after their length, and so is everything from the
+ * first line that is not such a pair.
+ *
+ * @param src The bytes of the block.
+ * @param size The number of bytes.
+ * @param dst The buffer for the rewritten block.
+ * @param capacity The size of the dst buffer.
+ * @return The number of rewritten bytes, or -1 when the block has no pairs or does not get smaller.
+*/
+int pairEncode(const unsigned char *src, int size, unsigned char *dst, int capacity);
+
+/**
+ * @brief Restores the lines of a block rewritten by pairEncode.
+ *
+ * @param src The rewritten bytes.
+ * @param size The number of rewritten bytes.
+ * @param dst The buffer for the lines.
+ * @param capacity The size of the dst buffer.
+ * @return The number of bytes restored, or -1 if the block is corrupt.
+*/
+int pairDecode(const unsigned char *src, int size, unsigned char *dst, int capacity);
+
+/**
+ * @brief Encodes bytes with canonical Huffman codes of at most CLZ_CODE_BITS bits, one code for the
+ * bytes after a byte below 128 (and the first byte) and one for the bytes after the others, so
+ * the first and the later bytes of varints get codes of their own: the number of bytes as a
+ * 4-byte little endian number, the code length of every byte value of each code in 128 bytes of
+ * nibbles, and the codes, the first bit of each in the lowest free bit.
+ *
+ * @param src The bytes to encode.
+ * @param size The number of bytes.
+ * @param dst The buffer for the encoded bytes.
+ * @param capacity The size of the dst buffer.
+ * @return The number of encoded bytes, or -1 when they do not fit in the buffer.
+*/
+int huffmanEncode(const unsigned char *src, int size, unsigned char *dst, int capacity);
+
+/**
+ * @brief Decodes bytes encoded by huffmanEncode.
+ *
+ * @param src The encoded bytes.
+ * @param size The number of encoded bytes.
+ * @param dst The buffer for the decoded bytes.
+ * @param capacity The size of the dst buffer.
+ * @return The number of decoded bytes, or -1 if they are corrupt.
+*/
+int huffmanDecode(const unsigned char *src, int size, unsigned char *dst, int capacity);
+
+/**
+ * @brief Compresses a whole stream into a CLZ frame: the magic "CLZ2", then for each block
+ * its raw size and its stored size as 4-byte little endian numbers followed by the stored bytes
+ * (kept raw when compression does not make it smaller), and a raw size of 0 at the end. A stored
+ * block starts with a byte of flags for the stages it went through, in order: CLZ_PAIRS for
+ * pairEncode, CLZ_LZ for clzCompressBlock and CLZ_HUFFMAN for huffmanEncode. Each stage is only
+ * kept when it makes the block smaller.
+ *
+ * @param in The stream to compress.
+ * @param out The stream the frame is written to.
+*/
+void clzCompress(FILE *in, FILE *out);
+
+/**
+ * @brief Finds the version of a CLZ frame from its magic.
+ *
+ * @param magic The first 4 bytes of the file.
+ * @return 2 for "CLZ2", 1 for the older "CLZ1" frames with LZ blocks only, 0 for other bytes.
+*/
+int clzVersion(const char *magic);
+
+/**
+ * @brief Decompresses a CLZ frame whose magic has already been read.
+ *
+ * @param in The stream the frame is read from.
+ * @param out The stream the decompressed bytes are written to.
+ * @param version The version of the frame, from clzVersion.
+ * @return 0 on success, -1 if the frame is corrupt or the output cannot be written.
+*/
+int clzDecompress(FILE *in, FILE *out, int version);
+
+/**
+ * @brief Implements the "--unpack" option by decompressing a CLZ file (such as an output of
+ * the --compress option) onto the screen.
+ *
+ * @param path The name of the compressed file.
+*/
+void implementUnpack(const char *path);
+
+/**
+ * @brief Implements the "--pack" option by compressing a file (such as an adjacency matrix)
+ * into <file>.clz, which the -i option can then read directly.
+ *
+ * @param path The name of the file to compress.
+*/
+void implementPack(const char *path);
+
+// A FlatBuffers message being built from its end towards its start, as FlatBuffers requires
+typedef struct {
+    unsigned char *data; // The buffer; the message takes its last size bytes
+    size_t capacity; // The size of the buffer
+    size_t size; // The number of bytes built so far
+    size_t minAlign; // The largest alignment needed by the message
+    size_t tableStart; // The size when the current table was started
+    size_t fields[8]; // The position of each field of the current table, 0 when absent
+    int fieldCount; // The number of fields of the current table
+} FlatBuilder;
+
+/**
+ * @brief Adds zero bytes so that the FlatBuffers message is aligned to align bytes once
+ * additional more bytes are added.
+ *
+ * @param fb The message being built.
+ * @param align The alignment needed.
+ * @param additional The number of bytes that will be added next.
+*/
+void fbPrep(FlatBuilder *fb, size_t align, size_t additional);
+
+/**
+ * @brief Adds an aligned little endian scalar to the FlatBuffers message.
+ *
+ * @param fb The message being built.
+ * @param value The value of the scalar.
+ * @param bytes The size of the scalar (1, 2, 4 or 8).
+*/
+void fbScalar(FlatBuilder *fb, uint64_t value, int bytes);
+
+/**
+ * @brief Adds an offset to an object already in the FlatBuffers message.
+ *
+ * @param fb The message being built.
+ * @param target The object, as returned when it was built.
+ * @return The position of the offset.
+*/
+size_t fbOffset(FlatBuilder *fb, size_t target);
+
+/**
+ * @brief Starts a table of the FlatBuffers message. Its fields are added with fbFieldScalar and
+ * fbFieldOffset, and no other object may be built until fbEndTable.
+ *
+ * @param fb The message being built.
+ * @param fieldCount The number of fields of the table in its schema.
+*/
+void fbStartTable(FlatBuilder *fb, int fieldCount);
+
+/**
+ * @brief Adds a scalar field to the current table.
+ *
+ * @param fb The message being built.
+ * @param slot The number of the field in the schema.
+ * @param value The value of the field.
+ * @param bytes The size of the field (1, 2, 4 or 8).
+*/
+void fbFieldScalar(FlatBuilder *fb, int slot, uint64_t value, int bytes);
+
+/**
+ * @brief Adds a field of the current table which refers to another object.
+ *
+ * @param fb The message being built.
+ * @param slot The number of the field in the schema.
+ * @param target The object, as returned when it was built.
+*/
+void fbFieldOffset(FlatBuilder *fb, int slot, size_t target);
+
+/**
+ * @brief Ends the current table by writing its vtable.
+ *
+ * @param fb The message being built.
+ * @return The table, to be referred to by other objects.
+*/
+size_t fbEndTable(FlatBuilder *fb);
+
+/**
+ * @brief Adds a string to the FlatBuffers message.
+ *
+ * @param fb The message being built.
+ * @param text The string.
+ * @return The string, to be referred to by other objects.
+*/
+size_t fbString(FlatBuilder *fb, const char *text);
+
+/**
+ * @brief Starts a vector of the FlatBuffers message. Its elements are then added from the last one
+ * to the first one, and the vector is ended with fbEndVector.
+ *
+ * @param fb The message being built.
+ * @param elementSize The size of an element.
+ * @param count The number of elements.
+ * @param align The alignment of an element.
+*/
+void fbStartVector(FlatBuilder *fb, size_t elementSize, size_t count, size_t align);
+
+/**
+ * @brief Ends a vector of the FlatBuffers message.
+ *
+ * @param fb The message being built.
+ * @param count The number of elements.
+ * @return The vector, to be referred to by other objects.
+*/
+size_t fbEndVector(FlatBuilder *fb, size_t count);
+
+// The pairs of the R* table gathered into the record batch of an Arrow stream
+typedef struct {
+    FILE *out; // The stream the Arrow stream is written to
+    int withHops; // Whether the stream has the hops column
+    int columns; // The number of columns
+    unsigned char *column[3]; // The little endian int32 values of source, destination and hops
+    int rows; // The number of rows in the current batch
+} ArrowWriter;
+
+/**
+ * @brief Starts an Arrow IPC stream by writing its schema: the int32 columns "source" and
+ * "destination", and optionally "hops", the number of links of the shortest route.
+ *
+ * @param out The stream the Arrow stream is written to.
+ * @param withHops Whether the stream has the hops column.
+ * @return The writer, to be given to writeArrowPair and finishArrowWriter.
+*/
+ArrowWriter *createArrowWriter(FILE *out, int withHops);
+
+/**
+ * @brief Adds a pair of the R* table to the Arrow stream, writing a record batch every
+ * ARROW_BATCH pairs.
+ *
+ * @param context The ArrowWriter.
+ * @param source The source city.
+ * @param destination The destination city.
+ * @param round The round the pair was found in.
+*/
+void writeArrowPair(void *context, int source, int destination, int round);
+
+/**
+ * @brief Writes the last record batch and the end of the Arrow stream, and frees the writer.
+ *
+ * @param writer The writer.
+*/
+void finishArrowWriter(ArrowWriter *writer);
+
+// The sampler thread that reports the progress of the R* table (--progress)
+typedef struct {
+    pthread_t thread; // The sampler thread
+    pthread_mutex_t lock; // Guards stop
+    pthread_cond_t wake; // Signalled to stop the sampler early
+    int stop; // Set when the R* table is complete
+    int running; // Whether the sampler thread was started
+    struct timespec start; // When the R* table was started
+} Progress;
+
+/**
+ * @brief Adds to a progress counter under progressLock, for compilers without atomics.
+ *
+ * @param counter The counter.
+ * @param amount The amount added, 0 to read it.
+ * @return The new value of the counter.
+*/
+long progressAdd(PROGRESS_LONG *counter, long amount);
+
+/**
+ * @brief Sets a progress counter under progressLock, for compilers without atomics.
+ *
+ * @param counter The counter.
+ * @param value The new value.
+*/
+void progressSet(PROGRESS_LONG *counter, long value);
+
+/**
+ * @brief Starts the sampler thread that reports the progress of the R* table every second, if
+ * --progress was given, and resets the counters the engines update.
+*/
+void startProgress(void);
+
+/**
+ * @brief Stops the sampler thread and reports the final count of pairs.
+*/
+void stopProgress(void);
+
+/**
+ * @brief Thread body that reads the progress counters every second and writes the round, the
+ * source cities completed, the pairs so far, the throughput and the estimated time left to
+ * stderr or to the status file. For the search per source city, the ETA assumes the remaining
+ * source cities take as long as the completed ones. The rounds engines do not know how many
+ * rounds are left, so their ETA is for the current round, from the source cities it has gone
+ * through so far.
+ *
+ * @param arg Unused.
+ * @return NULL.
+*/
+void *progressThread(void *arg);
+
+/**
+ * @brief Writes a line of progress to stderr, or replaces the status file with it.
+ *
+ * @param line The line.
+*/
+void writeProgress(const char *line);
+
+/**
+ * @brief Implements the "-i" option given by the user by opening the input file and reading 
+ * the adjacency matrix, then printing the adjacency matrix to the console.
+ * 
+ * @param filename A pointer to the filename string.
+ */
+void implementI (char **filename);
+
+/**
+ * @brief Implements the "-r" option by finding a path between two cities and 
+ * printing the path if it exists. It calls the findPath function, a depth first search with
+ * its own stack instead of recursion, unless --alternatives, --routes, --hops or --astar asks
+ * for another search.
+ * 
+ * @param filename A pointer to the filename string.
+*/
+void implementR (char **filename);
+
+/**
+ * @brief Reads the coordinates file given with --coords for the loaded network, once: a line
+ * "<latitude> <longitude>" in degrees for every city in order. It also builds the grid index of
+ * the cities used by snapCity.
+*/
+void loadCoordinates(void);
+
+/**
+ * @brief Finds the city nearest to a point with the grid index: the cells around the cell of the
+ * point are searched ring after ring, until the next ring cannot hold a nearer city. Distances
+ * are measured on the plane with the longitude scaled by the cosine of the mean latitude.
+ *
+ * @param latitude The latitude of the point in degrees.
+ * @param longitude The longitude of the point in degrees.
+ * @return The nearest city.
+*/
+int snapCity(double latitude, double longitude);
+
+/**
+ * @brief Finds the great-circle distance between two cities.
+ *
+ * @param a The first city.
+ * @param b The second city.
+ * @return The distance in kilometers.
+*/
+double cityDistance(int a, int b);
+
+/**
+ * @brief Finds the cheapest route between two cities with A*, using as lower bound the
+ * great-circle distance to the destination times the smallest cost per kilometer of any
+ * connection, and prints it like findPath followed by its cost. With --stats it prints the number
+ * of cities settled on stderr.
+ *
+ * @param source The source city.
+ * @param destination The destination city.
+ * @return 1 if a route is found, 0 if there is none, -1 if the --time-limit was reached first.
+*/
+int findRoute(int source, int destination);
+
+// A route found by findAlternatives
+typedef struct {
+    int *city; // The cities of the route, from the source to the destination
+    long long *cost; // The cost of the route up to each of its cities
+    int length; // The number of cities
+    int deviation; // The position where it leaves the route it was found from
+} Route;
+
+/**
+ * @brief Finds the given number of cheapest routes without loops between two cities with Yen's
+ * algorithm, and prints them in order of cost. The tree of cheapest routes into the destination is
+ * found once over the reversed network; every spur search of Yen's algorithm is an A* search guided
+ * by its exact distances, skips the cities that cannot reach the destination, and finishes as soon
+ * as it settles a city whose route in the tree avoids the blocked cities. Only the spur cities from
+ * where a route left the one it was found from are searched again (Lawler's improvement).
+ *
+ * @param source The source city.
+ * @param destination The destination city.
+ * @param count The number of routes.
+ * @return 1 if a route is found, 0 if there is none, -1 if the --time-limit was reached first.
+*/
+int findAlternatives(int source, int destination, int count);
+
+/**
+ * @brief Implements the "-p" option by calculating the transitive closure of 
+ * the cityMatrix and printing it to the console, using the calculateTransitiveClosure
+ * function.
+ * @param filename A pointer to the filename string.
+*/
+void implementP (char **filename);
+
+/**
+ * @brief Implements the "-o" option by creating an output file, calculating the 
+ * transitive closure, and then printing it to the file.
+ * @param filename A pointer to the filename string.
+*/
+void implementO (char **filename);
+
+/**
+ * @brief Implements the "--facilities" option: assigns every city to the nearest facility it can
+ * reach, by the number of connections or by their costs for a weighted network, with ties going
+ * to the facility with the smallest number. It is a single search from all the facilities at once
+ * over the reversed network, a breadth first search or Dijkstra's algorithm, and prints the
+ * facility and the distance of every city.
+ * @param filename A pointer to the filename string.
+ * @param list The facilities, separated by commas.
+*/
+void implementFacilities (char **filename, const char *list);
+
+/**
+ * @brief Reads a list of cities such as "0,4,10-19", separated by commas, with ranges of cities.
+ *
+ * @param list The text of the list.
+ * @param count Set to the number of cities.
+ * @return The cities in the order given, to be freed, or NULL if the list is invalid.
+*/
+int *parseCityList(const char *list, int *count);
+
+// The searches of one thread of the distance table
+typedef struct {
+    const int *origin; // The cities the searches start from
+    int originCount; // The number of origins
+    const int *slotHead; // The first slot of each city in the goals, -1 if it is not a goal
+    const int *slotNext; // The next slot of the same city, -1 after the last
+    int goalCount; // The number of slots of goals
+    int goalCities; // The number of different goal cities, where a search can stop
+    const long *start; // The adjacency lists the searches follow
+    const int *list;
+    const int *costs; // The costs of the connections, or NULL for a breadth first search
+    int forward; // 1 when the origins are the sources, 0 when they are the targets
+    int thread; // The number of this thread
+    int threads; // The number of threads
+    long long *table; // The distance table, sources by targets, -1 when unreachable
+} TableJob;
+
+/**
+ * @brief Thread body that fills the rows (or columns) of the distance table of every origin
+ * thread, thread + threads, ...; each search stops once it has settled every goal.
+ *
+ * @param arg The TableJob.
+ * @return NULL.
+*/
+void *tableThread(void *arg);
+
+/**
+ * @brief Implements the "--table" option: the distances from every source to every target, by
+ * the number of connections or by their costs. It runs one search per city of the smaller side,
+ * from the sources over the network or from the targets over the reversed network, on all the
+ * processors, and prints the table, or with --binary writes it to out-<filename>.dist.
+ * @param filename A pointer to the filename string.
+ * @param lists The sources and the targets, "<sources>/<targets>".
+*/
+void implementTable (char **filename, const char *lists);
+
+/**
+ * @brief Reads the failures file given with --failures for the loaded network, once: lines
+ * "<source> <destination> <probability>" with the chance that a connection fails, and optionally a
+ * line "* <probability>" for all the connections not listed, which otherwise never fail.
+*/
+void loadFailures(void);
+
+/**
+ * @brief Makes a word of 64 sampled worlds, each bit set with the chance that a connection works.
+ * The bits of the chance are taken from the lowest, ORing a random word for a 1 and ANDing one for
+ * a 0, so a chance of 24 bits costs at most 24 random words instead of 64 draws. The random words
+ * are a xorshift sequence started from a hash of the connection and the batch, so a connection
+ * looks the same every time it is met in a batch, and on every thread.
+ *
+ * @param e The index of the connection.
+ * @param batch The number of the batch of 64 worlds.
+ * @return The worlds in which the connection works.
+*/
+uint64_t sampleWorlds(long e, long batch);
+
+// The sampled worlds of one thread of the reliability estimate
+typedef struct {
+    int source; // The city the reliability is estimated from
+    long batches; // The number of batches of 64 worlds
+    int thread; // The number of this thread
+    int threads; // The number of threads
+    long *reached; // The number of worlds in which each city was reached
+    long done; // The batches this thread completed
+    long examined; // The connections whose worlds were sampled
+    uint64_t *worlds; // The worlds of every connection sampled in the current batch, or NULL without a cache
+    uint32_t *sampledIn; // The batch plus one each connection was last sampled in
+} ReliabilityJob;
+
+/**
+ * @brief Thread body that runs the batches thread, thread + threads, ... from the source: the
+ * worlds in which each city is reached are a word of bits, which spread along every connection in
+ * the worlds it works in, until no city gains a world.
+ *
+ * @param arg The ReliabilityJob.
+ * @return NULL.
+*/
+void *reliabilityThread(void *arg);
+
+/**
+ * @brief Implements the "--reliability" option: for every given source, the chance that each city
+ * stays reachable from it when the connections fail independently with the chances of --failures,
+ * estimated from --samples sampled worlds on all the processors.
+ * @param filename A pointer to the filename string.
+ * @param list The sources, such as "0" or "0-99".
+*/
+void implementReliability (char **filename, const char *list);
+
+// The share of one thread of the PageRank iterations
+typedef struct {
+    int first, last; // The cities whose ranks this thread calculates, first ... last - 1
+    int thread; // The number of this thread
+    int threads; // The number of threads
+    const long *inStart; // The connections into city v are inList[inStart[v]] ... inList[inStart[v + 1] - 1]
+    const int *inList;
+    double *rank[2]; // The ranks of the previous and the next iteration, swapped every iteration
+    double *share; // The rank every city passes along each of its connections
+    double *dangling; // The rank of the cities without connections of every thread
+    double *change; // The change of the ranks of every thread
+    pthread_barrier_t *barrier; // Where the threads wait for each other between the steps
+    int *finished; // Set by thread 0 once the ranks have converged or the time is up
+    int *iterations; // The number of iterations, counted by thread 0
+} PageRankJob;
+
+/**
+ * @brief Thread body of the PageRank iterations: every iteration first spreads the rank of its
+ * cities over their connections, then pulls the new rank of each of its cities from the cities
+ * connected into it, so no two threads write the same city.
+ *
+ * @param arg The PageRankJob.
+ * @return NULL.
+*/
+void *pageRankThread(void *arg);
+
+/**
+ * @brief Implements the "--pagerank" option: the stationary importance of every city for a walk
+ * that follows a random connection with the --damping chance and otherwise jumps to a random city,
+ * over the loaded adjacency lists on all the processors, until the ranks change less than
+ * PAGERANK_TOLERANCE in total. Cities without connections jump to a random city.
+ * @param filename A pointer to the filename string.
+*/
+void implementPageRank (char **filename);
+
+// The residual network of the maximum flow, with a pair of arcs for every connection
+typedef struct {
+    long *arcStart; // The arcs of city u are arcStart[u] ... arcStart[u + 1] - 1
+    int *arcTo; // The city each arc leads to
+    long *arcPair; // The arc in the other direction
+    long *arcEdge; // The connection of a forward arc, -1 for a backward arc
+    long long *residual; // The capacity left on each arc
+} FlowNetwork;
+
+// The cities at every height below N of the maximum flow in doubly linked lists, so that a gap only
+// goes through the cities above it
+typedef struct {
+    int *first; // The first city at each height, -1 for none
+    int *next; // The next city at the same height, -1 for none
+    int *previous; // The previous city at the same height, -1 for none
+    int highest; // No city below the height N is higher than this
+} HeightBuckets;
+
+/**
+ * @brief Builds the residual network of the loaded adjacency lists, without capacities yet.
+ *
+ * @param flow The network to fill.
+*/
+void buildFlowNetwork(FlowNetwork *flow);
+
+/**
+ * @brief Finds the heights of the cities as their number of arcs with capacity left to the sink,
+ * with a breadth first search back from it; cities that cannot reach it get the height N.
+ *
+ * @param flow The residual network.
+ * @param sink The sink city.
+ * @param height The heights to fill.
+ * @param queue Room for N cities.
+*/
+void globalRelabel(const FlowNetwork *flow, int sink, int *height, int *queue);
+
+/**
+ * @brief Finds the maximum flow between two cities with the FIFO push-relabel algorithm, with
+ * global relabeling every N relabels and the gap heuristic: when no city is left at a height, the
+ * cities above it cannot reach the sink any more. The cities are kept in HeightBuckets, so a gap
+ * only raises the cities above it instead of going through all of them. Only the first phase is run, which finds the value
+ * of the flow and leaves the minimum cut in the residual network.
+ *
+ * @param flow The residual network.
+ * @param source The source city.
+ * @param sink The sink city.
+ * @param unit Whether every connection has capacity 1 instead of its weight.
+ * @return The maximum flow, or -1 if the --time-limit was reached first.
+*/
+long long pushRelabel(FlowNetwork *flow, int source, int sink, int unit);
+
+/**
+ * @brief Implements the "--maxflow" option: the maximum flow between two cities with the weights of
+ * the connections as capacities, the links of a minimum cut, and the number of routes without a
+ * common connection (the maximum flow with capacities 1).
+ * @param filename A pointer to the filename string.
+*/
+void implementMaxflow (char **filename);
+
+// The searches of one thread of the shortest cycles
+typedef struct {
+    int thread; // The number of this thread
+    int threads; // The number of threads
+    long long *cycle; // The length of the shortest cycle through every city, -1 for none, -2 until found
+} CycleJob;
+
+/**
+ * @brief Finds the shortest cycles through the cities of the batches of 64 cities thread,
+ * thread + threads, ... with a breadth first search from all 64 at once: every city keeps the
+ * sources that reached it as the bits of a word, and a level spreads the words of the frontier along
+ * the connections. A source whose own bit comes back to it has its cycle, and drops out.
+ *
+ * @param arg The CycleJob.
+ * @return NULL.
+*/
+void *cycleBitsThread(void *arg);
+
+/**
+ * @brief Finds the cheapest cycles through the cities thread, thread + threads, ... with Dijkstra's
+ * algorithm from each: the cycle closes along a connection back into the source, and the search
+ * stops once it settles a city no cheaper than the cheapest cycle found.
+ *
+ * @param arg The CycleJob.
+ * @return NULL.
+*/
+void *cycleCostThread(void *arg);
+
+/**
+ * @brief Implements the "--cycles" option: the length of the shortest cycle through every city,
+ * by the number of connections or by their costs, and the girth, the shortest cycle of all, found
+ * on all the processors.
+ * @param filename A pointer to the filename string.
+*/
+void implementCycles (char **filename);
+
+// The searches of one thread of the routing table
+typedef struct {
+    int thread; // The number of this thread
+    int threads; // The number of threads
+} RoutesJob;
+
+/**
+ * @brief Thread body that fills the rows of the routing table of the sources thread,
+ * thread + threads, ... with a breadth first search from each: every city takes the first hop of
+ * the city it was reached from.
+ *
+ * @param arg The RoutesJob.
+ * @return NULL.
+*/
+void *routesThread(void *arg);
+
+/**
+ * @brief Finds the first hop from a source towards a destination in the routing table.
+ *
+ * @param source The source city.
+ * @param destination The destination city.
+ * @return The position of the first hop among the neighbors of the source, or -1 if there is none.
+*/
+long routeHop(int source, int destination);
+
+/**
+ * @brief Prints the route of fewest connections between two cities like findPath, following the
+ * routing table one hop at a time. A route the table does not hold to the end is left to findPath.
+ *
+ * @param source The source city.
+ * @param destination The destination city.
+ * @return 1 if a route is found, 0 if there is none.
+*/
+int followRoute(int source, int destination);
+
+/**
+ * @brief Implements the "--routes" option: the routing table of the first hop from every city
+ * towards every city it reaches on a route of fewest connections, found with a breadth first
+ * search per source on all the processors. Every entry is the position of the hop among the
+ * neighbors of the source, in 1, 2 or 4 bytes by the largest number of neighbors. It is saved to
+ * out-<filename>.routes and, unless the --time-limit cut it short, kept for -r; the tables of the
+ * given cities are also printed.
+ * @param filename A pointer to the filename string.
+ * @param list The cities whose tables are printed, or NULL.
+*/
+void implementRoutes (char **filename, const char *list);
+
+// The operands of a kernel of the all pairs engine, which adds to every cell [i][j] of the rows the
+// routes through the cities k0 ... k1-1, [i][k] ⊗ [k][j], k after k
+typedef struct {
+    unsigned char *rows; // The first row updated
+    size_t stride; // The bytes of a row
+    int count; // The number of rows updated
+    const unsigned char *via; // The cells [i][k] of the rows; the rows themselves, or a copy of the old ones
+    size_t viaStride; // The bytes from a row of via to the next
+    int viaFirst; // The column the cells of via start at
+    const unsigned char *next; // The rows of the cities k0 ... k1-1
+    int k0, k1; // The cities the routes go through
+} ApspBlock;
+
+// A semiring of the all pairs engine: the values of its cells and how they combine, with ⊕ choosing
+// between routes and ⊗ joining two routes end to end
+typedef struct {
+    const char *name; // The name given to --apsp
+    size_t cellBytes; // The bytes of a cell, 0 for a single bit
+    void (*clear)(void *row, int count); // Fills a row with the value of no route
+    void (*link)(void *row, int city, int cost); // Adds a connection of the given cost into the city to a row
+    void (*block)(const ApspBlock *block, int j0, int j1); // The kernel, for the columns j0 ... j1-1
+    void (*print)(const void *row, int city); // Prints a cell of a row
+} Semiring;
+
+/**
+ * @brief The kernel of the reach semiring (OR, AND) over rows of bits: every row that reaches a
+ * city k takes the words of row k covering the columns. The columns start at a whole word.
+ *
+ * @param block The operands.
+ * @param j0 The first column.
+ * @param j1 One past the last column.
+*/
+void reachBlock(const ApspBlock *block, int j0, int j1);
+
+/**
+ * @brief The kernel of the hops semiring (min, +) over int cells, [i][j] = min([i][j], [i][k] + [k][j]).
+ * The inner loop has no branches, so that the compiler turns it into vector instructions.
+ * The parameters are those of reachBlock.
+*/
+void hopsBlock(const ApspBlock *block, int j0, int j1);
+
+/**
+ * @brief The kernel of the cost semiring (min, +) over long long cells, like hopsBlock.
+ * The parameters are those of reachBlock.
+*/
+void costBlock(const ApspBlock *block, int j0, int j1);
+
+/**
+ * @brief Multiplies two numbers of routes, stopping at the largest unsigned long long.
+ *
+ * @param a The first number.
+ * @param b The second number.
+ * @return The product, or ULLONG_MAX if it overflows.
+*/
+unsigned long long multiplyRoutes(unsigned long long a, unsigned long long b);
+
+/**
+ * @brief Adds two numbers of routes, stopping at the largest unsigned long long.
+ *
+ * @param a The first number.
+ * @param b The second number.
+ * @return The sum, or ULLONG_MAX if it overflows.
+*/
+unsigned long long addRoutes(unsigned long long a, unsigned long long b);
+
+/**
+ * @brief The kernel of the count semiring over cells of a cost and a number of routes: ⊕ keeps the
+ * cheaper cost and adds the numbers of routes of equal costs, ⊗ adds the costs and multiplies the
+ * numbers, which stop at the largest unsigned long long.
+ * The parameters are those of reachBlock.
+*/
+void countBlock(const ApspBlock *block, int j0, int j1);
+
+// The blocks of one thread of a step of the all pairs engine
+typedef struct {
+    const Semiring *ring; // The semiring
+    unsigned char *matrix; // The rows of the matrix
+    size_t stride; // The bytes of a row
+    int k0, k1; // The cities of the step
+    int thread; // The number of this thread
+    int threads; // The number of threads
+} ApspJob;
+
+/**
+ * @brief Thread body that updates the rows of blocks thread, thread + threads, ... other than the
+ * one of the step: every row adds, k after k, its old routes into a city k of the step joined with
+ * the finished row of k. The old cells are copied first, since the row changes underneath.
+ *
+ * @param arg The ApspJob.
+ * @return NULL.
+*/
+void *apspThread(void *arg);
+
+/**
+ * @brief Closes a matrix over a semiring, the same blocked algorithm for every semiring. For each
+ * block K of APSP_BLOCK cities it closes the block on the diagonal with Floyd-Warshall, then adds to
+ * the rest of the rows of K their old routes joined through that block, and then to every other row
+ * its old routes into K joined with the new rows of K, on all the processors. Every route is so
+ * counted once, by its first and last city in K, which the count semiring needs; the kernels work
+ * on blocks of columns that stay in the caches. A cell ends up as the ⊕ of the routes of one or
+ * more connections, so the diagonal holds the routes around cycles.
+ *
+ * @param ring The semiring.
+ * @param matrix The rows of the matrix, starting with the connections.
+ * @param stride The bytes of a row.
+ * @return 1 when it finished, 0 when the --time-limit stopped it.
+*/
+int closeSemiring(const Semiring *ring, unsigned char *matrix, size_t stride);
+
+/**
+ * @brief Implements the "--apsp" option: prints the matrix of all pairs of cities closed over the
+ * given semiring, "reach" for 0/1, "hops" for the fewest connections, "cost" for the cheapest
+ * cost and "count" for the number of cheapest routes.
+ * @param filename A pointer to the filename string.
+ * @param name The name of the semiring.
+*/
+void implementApsp (char **filename, const char *name);
+
+// What the next step of a query of the batch executor does
+enum { QUERY_POP, QUERY_ROW, QUERY_MARK, QUERY_SCAN };
+
+// A query of the batch executor: a breadth first search that runs one step at a time
+typedef struct {
+    long index; // The position of the query in the file, -1 for a free slot
+    int destination; // The destination city
+    int stage; // What the next step does
+    int city; // The city being expanded
+    int level; // The connections from the source to the cities being expanded
+    int *queue; // The cities reached, in the order they were reached
+    long head, tail, capacity; // The next city to expand, the end and the size of the queue
+    long levelEnd; // The end of the cities of the current level in the queue
+    long edge, edgeEnd; // The connections of the city being expanded
+    uint64_t *visited; // The cities reached, as bits
+} Query;
+
+// The queries of one thread of the batch executor
+typedef struct {
+    int thread; // The number of this thread
+    int threads; // The number of threads
+    long count; // The number of queries
+    const int *sources, *destinations; // The cities of every query
+    int *answers; // The connections of every answer, -1 for no route, -2 until answered
+} QueryJob;
+
+/**
+ * @brief Starts a query in a slot of the batch executor.
+ *
+ * @param query The slot.
+ * @param index The position of the query.
+ * @param source The source city.
+ * @param destination The destination city.
+*/
+void startQuery(Query *query, long index, int source, int destination);
+
+/**
+ * @brief Runs the next step of a query: taking the next city of the queue, reading where its
+ * connections are, prefetching the marks of its neighbors, or going through them. Each step
+ * prefetches what the next one reads, so that the load is in flight while the executor runs the
+ * steps of the other queries.
+ *
+ * @param query The query.
+ * @param answer Set to the connections of the route, or -1 for none, when the query finishes.
+ * @return 1 when the query finished, 0 otherwise.
+*/
+int stepQuery(Query *query, int *answer);
+
+/**
+ * @brief Thread body that answers the queries thread, thread + threads, ... --interleave at a time:
+ * it runs a step of each query in turn and starts the next query in the slot of one that finished,
+ * so that a core waits for memory far less often than with one query at a time.
+ *
+ * @param arg The QueryJob.
+ * @return NULL.
+*/
+void *queryThread(void *arg);
+
+/**
+ * @brief Implements the "--queries" option: answers the queries of a file, a line
+ * "<source> <destination>" each, with the fewest connections between the cities, on all the
+ * processors with the queries of each thread interleaved.
+ * @param filename A pointer to the filename string.
+ * @param queries The file of the queries.
+*/
+void implementQueries (char **filename, const char *queries);
+
+/**
+ * @brief Implements the "--encode" option by writing the adjacency matrix of the input file
+ * to <filename>.<encoding> with its rows in the given encoding.
+ * @param filename A pointer to the filename string.
+ * @param name The name of the encoding.
+*/
+void implementEncode (char **filename, const char *name);
+
+int N; // The number of cities
+int **cityMatrix; // The adjacency matrix (NULL for a list of connections)
+long *rowStart; // The neighbors of city u are adjacency[rowStart[u]] ... adjacency[rowStart[u + 1] - 1]
+int *adjacency; // The neighbors of all the cities, in ascending order for each city
+int *weight; // The cost of every connection in adjacency, NULL when they all cost 1
+char *coordinatesFile = NULL; // The file with the latitude and longitude of every city (--coords)
+double *latitude, *longitude; // The coordinates of every city in degrees, NULL until loaded
+double *planeX, *planeY; // The coordinates on the plane of the grid index
+double gridLeft, gridBottom, gridCell; // The corner and the cell size of the grid index
+double gridScale; // The length on the plane of a degree of longitude
+int gridWidth, gridHeight; // The number of cells of the grid index
+int *cellStart, *cellCities; // The cities of cell c are cellCities[cellStart[c]] ... cellCities[cellStart[c + 1] - 1]
+int binaryTable = 0; // Whether --table writes a binary file instead of text (--binary)
+int astarRoute = 0; // Whether -r finds the cheapest route with A* (--astar)
+int alternativeRoutes = 0; // The number of cheapest routes -r prints, 0 for any route (--alternatives)
+char *failuresFile = NULL; // The file with the chances that the connections fail (--failures)
+uint32_t *survival; // The chance that every connection works, in 1/2^24, NULL until loaded
+double damping = 0.85; // The chance that the PageRank walk follows a connection (--damping)
+long sampleCount = 65536; // The number of sampled worlds of --reliability (--samples)
+int queryGroup = 8; // The queries each thread of --queries interleaves (--interleave)
+int hopsOnly = 0; // Whether the searches count connections instead of adding their costs (--hops)
+long edgeCount; // The number of connections
+char *loadedFile; // The name of the input file the network was loaded from
+int statsOutput = 0; // Whether loading a network prints its statistics (--stats)
+int closureEngine = ENGINE_AUTO; // The engine asked for with --engine
+int activeEngine = ENGINE_AUTO; // The engine chosen by planClosure
+const char *engineNames[] = {"auto", "rounds", "bfs", "bitset", "chains", "fastest"};
+int componentCount; // The number of strongly connected components, for the chains engine
+int *cityComponent; // The component of every city, NULL until the chains are built
+int *componentStart, *componentCities; // The cities of component x are componentCities[componentStart[x]] ..., ascending
+unsigned char *componentCycle; // Whether the cities of each component reach each other through a cycle
+unsigned char *routeTable; // The first hop from every city to every city, N x N entries of routeWidth bytes, NULL until found (--routes)
+int routeWidth; // The bytes of an entry of the routing table
+int chainCount; // The number of chains covering the components
+int *chainStart, *chainComponents; // The components of chain c, in order, are chainComponents[chainStart[c]] ...
+int *chainOf, *chainPosition; // The chain of every component and its position on it
+int *chainLabels; // The earliest position every component reaches on every chain, INT_MAX for none, NULL until built
+uint64_t *adjacencyBits; // The adjacency matrix as rows of bits, for the bitset engine
+long *incomingStart; // The connections into city v are incoming[incomingStart[v]] ..., NULL until built
+int *incoming; // The sources of the connections into every city, ascending
+PROGRESS_LONG directionCount[64][2]; // The top-down and bottom-up rounds of the search engine at every level, for --stats
+double tuneCost[2][3]; // The nanoseconds per reached city of the bitset engine and the search: fixed, per word or connection, per doubling of N (--autotune)
+int bandwidthOutput = 0; // Whether the bitset engine reports its memory bandwidth (--bandwidth)
+double peakBandwidth = 0; // The bandwidth measured by memoryBandwidth in bytes per second
+int tuneLoaded = 0; // 1 once the tuning profile was loaded, -1 once it was found missing
+size_t memLimit = 0; // The memory the program may use in bytes, 0 for no limit (--mem-limit)
+double timeLimit = 0; // The seconds each command may take, 0 for no limit (--time-limit)
+struct timespec deadline; // The time the current command has to stop
+volatile int cancelled = 0; // Set once the current command has passed its deadline
+int timedOut = 0; // Whether a command was stopped by the time limit, for the exit status
+int progressOutput = 0; // Whether the R* table reports its progress (--progress)
+char *progressFile = NULL; // The status file for the progress, NULL for stderr
+Progress progress; // The sampler thread of the progress
+pthread_mutex_t progressLock = PTHREAD_MUTEX_INITIALIZER; // Guards the progress counters when there are no atomics
+PROGRESS_LONG progressPairs; // The pairs found so far, updated by the engines with relaxed atomics
+PROGRESS_LONG progressRows; // The source cities completed so far
+PROGRESS_LONG progressRound; // The current round of the rounds engines
+PROGRESS_LONG progressSteps; // The source cities the rounds engines have gone through in all their rounds
+int shardCount = 1; // The number of files the -o option splits the R* table into (--shards)
+int compressOutput = 0; // Whether the -o option writes CLZ compressed files (--compress)
+int arrowOutput = 0; // Whether the -o option writes an Arrow stream: 1 for pairs, 2 with hops (--arrow)
+int matrixOutput = 0; // Whether -p and -o write the R* table as a 0/1 matrix (--as-matrix)
+
+#define CLZ_MAGIC "CLZ2" // The first bytes of a CLZ frame
+#define CLZ_MAGIC_LZ "CLZ1" // The first bytes of the older CLZ frames with LZ blocks only
+#define CLZ_PAIRS 1 // The flag of a block whose pairs were rewritten by pairEncode
+#define CLZ_LZ 2 // The flag of a block compressed by clzCompressBlock
+#define CLZ_HUFFMAN 4 // The flag of a block Huffman coded by huffmanEncode
+#define CLZ_CODE_BITS 15 // The longest Huffman code
+#define CLZ_BLOCK 65536 // The number of raw bytes in a CLZ block
+#define CLZ_BOUND(size) ((size) + (size) / 255 + 16) // The largest compressed size of a block
+#define CLZ_HASH_BITS 16 // The size of the match finder table as a power of two
+#define ARROW_BATCH 65536 // The number of pairs in an Arrow record batch
+#define RADIANS (3.14159265358979323846 / 180) // The radians in a degree
+#define EARTH_RADIUS 6371.0 // The mean radius of the earth in kilometers
+#define SURVIVAL_BITS 24 // The precision of the chance that a connection works
+#define PAGERANK_TOLERANCE 1e-10 // The total change of the ranks at which PageRank stops
+#define PAGERANK_ITERATIONS 1000 // The most iterations of PageRank
+#define CHAIN_CITIES 1024 // The smallest network the planner uses the chains engine for
+#define DIRECTION_ALPHA 14 // A search goes bottom-up once a growing frontier has more connections than 1/ALPHA of those left
+#define DIRECTION_BETA 24 // and back top-down once the frontier has fewer than 1/BETA of the cities
+#define APSP_BLOCK 64 // The cities of a block of the all pairs engine, a multiple of 64
+#define HOPS_NONE (INT_MAX / 2) // The hops of no route, which two of can still be added
+#define COST_NONE (LLONG_MAX / 4) // The cost of no route
+#define MAX_CITIES (INT_MAX / 2) // The most cities of a network, so that twice their number and HOPS_NONE fit an int
+
+// A hint that an address is read soon, so that the load starts before it is needed
+#if defined(__GNUC__)
+#define PREFETCH(address) __builtin_prefetch(address)
+#else
+#define PREFETCH(address) ((void)(address))
+#endif
+
+// The long options; those without a short option use values outside the character range
+enum { OPT_SHARDS = 256, OPT_COMPRESS, OPT_UNPACK, OPT_PACK, OPT_ENCODE, OPT_ARROW, OPT_AS_MATRIX, OPT_STATS, OPT_ENGINE, OPT_MEM_LIMIT, OPT_TIME_LIMIT, OPT_PROGRESS, OPT_AUTOTUNE, OPT_BANDWIDTH, OPT_FACILITIES, OPT_HOPS, OPT_COORDS, OPT_ASTAR, OPT_TABLE, OPT_BINARY, OPT_ALTERNATIVES, OPT_FAILURES, OPT_RELIABILITY, OPT_SAMPLES, OPT_PAGERANK, OPT_DAMPING, OPT_MAXFLOW, OPT_CYCLES, OPT_ROUTES, OPT_APSP, OPT_QUERIES, OPT_INTERLEAVE };
+static struct option longOptions[] = {
+    {"shards", required_argument, NULL, OPT_SHARDS},
+    {"compress", no_argument, NULL, OPT_COMPRESS},
+    {"unpack", required_argument, NULL, OPT_UNPACK},
+    {"pack", required_argument, NULL, OPT_PACK},
+    {"encode", required_argument, NULL, OPT_ENCODE},
+    {"arrow", optional_argument, NULL, OPT_ARROW},
+    {"as-matrix", no_argument, NULL, OPT_AS_MATRIX},
+    {"stats", no_argument, NULL, OPT_STATS},
+    {"engine", required_argument, NULL, OPT_ENGINE},
+    {"mem-limit", required_argument, NULL, OPT_MEM_LIMIT},
+    {"time-limit", required_argument, NULL, OPT_TIME_LIMIT},
+    {"progress", optional_argument, NULL, OPT_PROGRESS},
+    {"autotune", no_argument, NULL, OPT_AUTOTUNE},
+    {"bandwidth", no_argument, NULL, OPT_BANDWIDTH},
+    {"facilities", required_argument, NULL, OPT_FACILITIES},
+    {"hops", no_argument, NULL, OPT_HOPS},
+    {"coords", required_argument, NULL, OPT_COORDS},
+    {"astar", no_argument, NULL, OPT_ASTAR},
+    {"table", required_argument, NULL, OPT_TABLE},
+    {"binary", no_argument, NULL, OPT_BINARY},
+    {"alternatives", required_argument, NULL, OPT_ALTERNATIVES},
+    {"failures", required_argument, NULL, OPT_FAILURES},
+    {"reliability", required_argument, NULL, OPT_RELIABILITY},
+    {"samples", required_argument, NULL, OPT_SAMPLES},
+    {"pagerank", no_argument, NULL, OPT_PAGERANK},
+    {"damping", required_argument, NULL, OPT_DAMPING},
+    {"maxflow", required_argument, NULL, OPT_MAXFLOW},
+    {"cycles", no_argument, NULL, OPT_CYCLES},
+    {"routes", optional_argument, NULL, OPT_ROUTES},
+    {"apsp", required_argument, NULL, OPT_APSP},
+    {"queries", required_argument, NULL, OPT_QUERIES},
+    {"interleave", required_argument, NULL, OPT_INTERLEAVE},
+    {0, 0, 0, 0}
+};
+
+int main (int argc, char *argv[]){
+
+    run(argc, argv);
+    return timedOut ? EXIT_FAILURE : 0;
+}
+
+ void run (int argc, char *argv[]){
+
+    int option;
+    char *filename = NULL;
+    int standalone = 0; // Set by the options which do not need an input file
+
+    if (argc == 1) {
+        fprintf(stderr, "No command line arguments given!\n");
+        fprintf(stderr, "Usage: %s -i <filename> -r <source_city>,<destination_city> -p -o <output_file>\n", argv[0]);
+        exit(EXIT_FAILURE);
+    }
+
+    parseSettings(argc, argv);
+
+    // Second pass: run the implementations in the order they were given
+    optind = 0;
+    while ((option = getopt_long(argc, argv, "i:r:po", longOptions, NULL)) != -1) {
+        switch (option) {
+            case 'i':
+                implementI(&filename);
+                break;
+            case 'r':
+                implementR(&filename);
+                break;
+            case 'p':
+                implementP(&filename);
+                break;
+            case 'o':
+                implementO(&filename);
+                break;
+            case OPT_UNPACK:
+                implementUnpack(optarg);
+                standalone = 1;
+                break;
+            case OPT_PACK:
+                implementPack(optarg);
+                standalone = 1;
+                break;
+            case OPT_AUTOTUNE:
+                implementAutotune();
+                standalone = 1;
+                break;
+            case OPT_ENCODE:
+                implementEncode(&filename, optarg);
+                break;
+            case OPT_FACILITIES:
+                implementFacilities(&filename, optarg);
+                break;
+            case OPT_TABLE:
+                implementTable(&filename, optarg);
+                break;
+            case OPT_RELIABILITY:
+                implementReliability(&filename, optarg);
+                break;
+            case OPT_PAGERANK:
+                implementPageRank(&filename);
+                break;
+            case OPT_MAXFLOW:
+                implementMaxflow(&filename);
+                break;
+            case OPT_CYCLES:
+                implementCycles(&filename);
+                break;
+            case OPT_ROUTES:
+                implementRoutes(&filename, optarg);
+                break;
+            case OPT_APSP:
+                implementApsp(&filename, optarg);
+                break;
+            case OPT_QUERIES:
+                implementQueries(&filename, optarg);
+                break;
+            case OPT_SHARDS:
+            case OPT_COMPRESS:
+            case OPT_ARROW:
+            case OPT_AS_MATRIX:
+            case OPT_STATS:
+            case OPT_ENGINE:
+            case OPT_MEM_LIMIT:
+            case OPT_TIME_LIMIT:
+            case OPT_PROGRESS:
+            case OPT_BANDWIDTH:
+            case OPT_HOPS:
+            case OPT_COORDS:
+            case OPT_ASTAR:
+            case OPT_BINARY:
+            case OPT_ALTERNATIVES:
+            case OPT_FAILURES:
+            case OPT_SAMPLES:
+            case OPT_DAMPING:
+            case OPT_INTERLEAVE:
+                break;
+            case '?':
+                fprintf(stderr, "Usage: %s -i <inputfile> [-r <source>,<destination> -p -o]\n", argv[0]);
+                exit(EXIT_FAILURE);
+        }
+    }
+
+
+    // Check if the -i option was provided
+    if (filename == NULL && !standalone) {
+        fprintf(stderr, "No input file given!\n");
+        fprintf(stderr, "Usage: %s -i <filename> [-r <source_city>,<destination_city> -p -o <output_file]\n", argv[0]);
+        exit(EXIT_FAILURE);
+    }
+}
+
+void parseSettings(int argc, char *argv[]) {
+    int option;
+
+    // Errors are reported by the second pass
+    opterr = 0;
+    while ((option = getopt_long(argc, argv, "i:r:po", longOptions, NULL)) != -1) {
+        switch (option) {
+            case OPT_SHARDS:
+                if (sscanf(optarg, "%d", &shardCount) != 1 || shardCount < 1) {
+                    fprintf(stderr, "Invalid number of shards: %s\n", optarg);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case OPT_COMPRESS:
+                compressOutput = 1;
+                break;
+            case OPT_ARROW:
+                if (optarg == NULL)
+                    arrowOutput = 1;
+                else if (strcmp(optarg, "hops") == 0)
+                    arrowOutput = 2;
+                else {
+                    fprintf(stderr, "Invalid Arrow column: %s (use --arrow or --arrow=hops)\n", optarg);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case OPT_AS_MATRIX:
+                matrixOutput = 1;
+                break;
+            case OPT_STATS:
+                statsOutput = 1;
+                break;
+            case OPT_ENGINE:
+                if (strcmp(optarg, "rounds") == 0)
+                    closureEngine = ENGINE_ROUNDS;
+                else if (strcmp(optarg, "bfs") == 0)
+                    closureEngine = ENGINE_BFS;
+                else if (strcmp(optarg, "bitset") == 0)
+                    closureEngine = ENGINE_BITSET;
+                else if (strcmp(optarg, "chains") == 0)
+                    closureEngine = ENGINE_CHAINS;
+                else if (strcmp(optarg, "fastest") == 0)
+                    closureEngine = ENGINE_FASTEST;
+                else {
+                    fprintf(stderr, "Invalid engine: %s (use rounds, bitset, bfs, chains or fastest)\n", optarg);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case OPT_MEM_LIMIT: {
+                double amount;
+                char unit = '\0';
+                int read = sscanf(optarg, "%lf%c", &amount, &unit);
+                const char *units = "BKMGT";
+                const char *found = strchr(units, toupper((unsigned char)unit));
+
+                if (read < 1 || amount <= 0 || (read == 2 && (unit == '\0' || found == NULL))) {
+                    fprintf(stderr, "Invalid memory limit: %s (use a size such as 512M or 4G)\n", optarg);
+                    exit(EXIT_FAILURE);
+                }
+                if (read == 2)
+                    amount *= (double)(1ULL << (10 * (found - units)));
+                memLimit = (size_t)amount;
+                break;
+            }
+            case OPT_BANDWIDTH:
+                bandwidthOutput = 1;
+                break;
+            case OPT_HOPS:
+                hopsOnly = 1;
+                break;
+            case OPT_COORDS:
+                coordinatesFile = optarg;
+                break;
+            case OPT_ASTAR:
+                astarRoute = 1;
+                break;
+            case OPT_BINARY:
+                binaryTable = 1;
+                break;
+            case OPT_FAILURES:
+                failuresFile = optarg;
+                break;
+            case OPT_DAMPING: {
+                char *end;
+                damping = strtod(optarg, &end);
+                if (end == optarg || *end != '\0' || damping < 0 || damping >= 1) {
+                    fprintf(stderr, "Invalid damping: %s (use a chance from 0 up to 1, such as 0.85)\n", optarg);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            }
+            case OPT_SAMPLES:
+                if (sscanf(optarg, "%ld", &sampleCount) != 1 || sampleCount < 1) {
+                    fprintf(stderr, "Invalid number of samples: %s\n", optarg);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case OPT_INTERLEAVE:
+                if (sscanf(optarg, "%d", &queryGroup) != 1 || queryGroup < 1) {
+                    fprintf(stderr, "Invalid number of interleaved queries: %s\n", optarg);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case OPT_ALTERNATIVES:
+                if (sscanf(optarg, "%d", &alternativeRoutes) != 1 || alternativeRoutes < 1) {
+                    fprintf(stderr, "Invalid number of routes: %s\n", optarg);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case OPT_PROGRESS:
+                progressOutput = 1;
+                progressFile = optarg;
+                break;
+            case OPT_TIME_LIMIT: {
+                char *end;
+                timeLimit = strtod(optarg, &end);
+                if (end == optarg || *end != '\0' || timeLimit <= 0) {
+                    fprintf(stderr, "Invalid time limit: %s (use a number of seconds)\n", optarg);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            }
+        }
+    }
+
+    if (arrowOutput && matrixOutput) {
+        fprintf(stderr, "The --arrow and --as-matrix options cannot be used together.\n");
+        exit(EXIT_FAILURE);
+    }
+    opterr = 1;
+}
+
+// Function to allocate memory for a matrix and initialize it to zeros
+int** createMatrix(int rows) {
+    int i;
+    int **matrix = (int **)malloc(rows * sizeof(int *));
+    for (i = 0; i < rows; i++) {
+        matrix[i] = (int *)calloc(N, sizeof(int));
+    }
+    return matrix;
+}
+
+// Function that frees a matrix
+void freeMatrix(int **matrix, int rows) {
+    int i;
+    for (i = 0; i < rows; i++) {
+        free(matrix[i]);
+    }
+    free(matrix);
+}
+
+const char *encodingNames[] = {"plain", "bits", "hex", "rle", "edges", "weighted"};
+
+int parseEncoding(const char *name) {
+    int encoding;
+    for (encoding = ENC_PLAIN; encoding <= ENC_WEIGHTED; encoding++) {
+        if (strcmp(name, encodingNames[encoding]) == 0)
+            return encoding;
+    }
+    return -1;
+}
+
+void readAdjacencyMatrix(FILE *inputFile) {
+    freeGraph();
+
+    if (fscanf(inputFile, "%d", &N) != 1 || N < 0) {
+        fprintf(stderr, "Error: Failed to read the number of cities from the input file.\n");
+        exit(EXIT_FAILURE);
+    }
+    if (N > MAX_CITIES) {
+        fprintf(stderr, "Error: The input file has more than %d cities.\n", MAX_CITIES);
+        exit(EXIT_FAILURE);
+    }
+
+    // An optional token on the same line names the encoding of the rows
+    int encoding = ENC_PLAIN;
+    int c;
+    do {
+        c = getc(inputFile);
+    } while (c == ' ' || c == '\t');
+
+    if (isalpha(c)) {
+        char name[16];
+        int length = 0;
+        while (isalpha(c) && length < 15) {
+            name[length++] = (char)c;
+            c = getc(inputFile);
+        }
+        name[length] = '\0';
+
+        encoding = parseEncoding(name);
+        if (encoding < 0) {
+            fprintf(stderr, "Error: Unknown row encoding %s in the input file.\n", name);
+            exit(EXIT_FAILURE);
+        }
+    }
+    else if (c != EOF) {
+        ungetc(c, inputFile);
+    }
+
+    if (encoding == ENC_EDGES || encoding == ENC_WEIGHTED) {
+        readEdgeList(inputFile, encoding == ENC_WEIGHTED);
+        return;
+    }
+
+    // Create a dynamic 2D array to store the adjacency matrix, unless it does not fit in the
+    // --mem-limit; the rows then only go into the adjacency lists
+    size_t matrixBytes = (size_t)N * ((size_t)N * sizeof(int) + sizeof(int *));
+    int *rowBuffer = NULL;
+    if (memLimit > 0 && matrixBytes + ((size_t)N + 1) * sizeof(long) > memLimit)
+        rowBuffer = (int *)malloc(((size_t)N + 1) * sizeof(int));
+    else
+        cityMatrix = createMatrix(N);
+
+    int i,j;
+    char *line = NULL;
+    size_t capacity = 0;
+    ssize_t length;
+    long edgeCapacity = 1024;
+
+    rowStart = (long *)malloc(((size_t)N + 1) * sizeof(long));
+    adjacency = (int *)malloc(edgeCapacity * sizeof(int));
+    rowStart[0] = 0;
+
+    // Read the adjacency matrix from the input file
+    for (i = 0; i < N; i++) {
+        int status = 0;
+        int *row = cityMatrix != NULL ? cityMatrix[i] : rowBuffer;
+
+        switch (encoding) {
+            case ENC_PLAIN:
+                for (j = 0; j < N && status == 0; j++) {
+                    if (fscanf(inputFile, "%d", &row[j]) != 1)
+                        status = -1;
+                }
+                break;
+            case ENC_RLE:
+                status = decodeRleRow(inputFile, row);
+                break;
+            default:
+                // Bit and hex rows take one line each, without the spaces around them
+                do {
+                    length = getline(&line, &capacity, inputFile);
+                    while (length > 0 && isspace((unsigned char)line[length - 1]))
+                        length--;
+                } while (length == 0);
+
+                if (length < 0)
+                    status = -1;
+                else if (encoding == ENC_BITS)
+                    status = decodeBitsRow(line, (size_t)length, row);
+                else
+                    status = decodeHexRow(line, (size_t)length, row);
+                break;
+        }
+
+        if (status != 0) {
+            fprintf(stderr, "Error: Failed to read the adjacency matrix from the input file.\n");
+            exit(EXIT_FAILURE);
+        }
+
+        appendRow(i, row, &edgeCapacity);
+    }
+    free(line);
+    free(rowBuffer);
+}
+
+int decodeBitsRow(const char *text, size_t length, int *row) {
+    const uint64_t zeros = 0x3030303030303030ULL; // Eight '0' characters
+    const uint64_t ones = 0x0101010101010101ULL;
+    size_t j = 0, k;
+
+    if (length != (size_t)N)
+        return -1;
+
+    for (; j + 8 <= length; j += 8) {
+        uint64_t word;
+        memcpy(&word, text + j, 8);
+
+        // Every byte must be '0' or '1', so only the lowest bit may differ from '0'
+        if (((word ^ zeros) & ~ones) != 0)
+            return -1;
+        for (k = 0; k < 8; k++)
+            row[j + k] = text[j + k] - '0';
+    }
+
+    for (; j < length; j++) {
+        if (text[j] != '0' && text[j] != '1')
+            return -1;
+        row[j] = text[j] - '0';
+    }
+    return 0;
+}
+
+int decodeHexRow(const char *text, size_t length, int *row) {
+    static int nibbleValue[256]; // The value of each hex digit, -1 for other characters
+    static int nibbleCells[16][4]; // The 4 cities held by each hex digit
+    static int ready = 0;
+    size_t j;
+    int k;
+
+    if (!ready) {
+        for (k = 0; k < 256; k++)
+            nibbleValue[k] = isxdigit(k) ? (isdigit(k) ? k - '0' : tolower(k) - 'a' + 10) : -1;
+        for (k = 0; k < 16; k++) {
+            nibbleCells[k][0] = (k >> 3) & 1;
+            nibbleCells[k][1] = (k >> 2) & 1;
+            nibbleCells[k][2] = (k >> 1) & 1;
+            nibbleCells[k][3] = k & 1;
+        }
+        ready = 1;
+    }
+
+    if (length != (size_t)(N + 3) / 4)
+        return -1;
+
+    // All the full digits are copied four cities at a time
+    for (j = 0; j < (size_t)N / 4; j++) {
+        int value = nibbleValue[(unsigned char)text[j]];
+        if (value < 0)
+            return -1;
+        memcpy(row + 4 * j, nibbleCells[value], sizeof(nibbleCells[value]));
+    }
+
+    if (N % 4 != 0) {
+        int value = nibbleValue[(unsigned char)text[j]];
+        if (value < 0 || (value & ((1 << (4 - N % 4)) - 1)) != 0)
+            return -1;
+        for (k = 0; k < N % 4; k++)
+            row[4 * j + k] = nibbleCells[value][k];
+    }
+    return 0;
+}
+
+int decodeRleRow(FILE *inputFile, int *row) {
+    int j = 0, k;
+
+    while (j < N) {
+        int value, count;
+        if (fscanf(inputFile, "%d %d", &value, &count) != 2 || count < 1 || count > N - j)
+            return -1;
+
+        if (value == 0) {
+            memset(row + j, 0, count * sizeof(int));
+        }
+        else {
+            for (k = 0; k < count; k++)
+                row[j + k] = value;
+        }
+        j += count;
+    }
+    return 0;
+}
+
+void writeEncodedMatrix(FILE *out, int encoding) {
+    int i,j;
+
+    if (encoding == ENC_PLAIN)
+        fprintf(out, "%d\n", N);
+    else
+        fprintf(out, "%d %s\n", N, encodingNames[encoding]);
+
+    if (encoding == ENC_EDGES || encoding == ENC_WEIGHTED) {
+        long e;
+        for (i = 0; i < N; i++) {
+            for (e = rowStart[i]; e < rowStart[i + 1]; e++) {
+                if (encoding == ENC_WEIGHTED)
+                    fprintf(out, "%d %d %d\n", i, adjacency[e], weight != NULL ? weight[e] : 1);
+                else
+                    fprintf(out, "%d %d\n", i, adjacency[e]);
+            }
+        }
+        return;
+    }
+
+    // A list of connections is written row by row from the adjacency lists
+    int *expanded = cityMatrix == NULL ? (int *)malloc(N * sizeof(int)) : NULL;
+
+    for (i = 0; i < N; i++) {
+        int *row = cityMatrix != NULL ? cityMatrix[i] : expanded;
+        if (cityMatrix == NULL)
+            expandRow(i, row);
+
+        switch (encoding) {
+            case ENC_PLAIN:
+                for (j = 0; j < N; j++)
+                    fprintf(out, j < N - 1 ? "%d " : "%d", row[j]);
+                break;
+            case ENC_BITS:
+                for (j = 0; j < N; j++)
+                    putc('0' + row[j], out);
+                break;
+            case ENC_HEX:
+                for (j = 0; j < N; j += 4) {
+                    int value = 0, k;
+                    for (k = 0; k < 4; k++)
+                        value = (value << 1) | (j + k < N ? row[j + k] : 0);
+                    putc("0123456789abcdef"[value], out);
+                }
+                break;
+            case ENC_RLE:
+                for (j = 0; j < N; ) {
+                    int count = 1;
+                    while (j + count < N && row[j + count] == row[j])
+                        count++;
+                    fprintf(out, j == 0 ? "%d %d" : " %d %d", row[j], count);
+                    j += count;
+                }
+                break;
+        }
+        putc('\n', out);
+    }
+    free(expanded);
+}
+
+int findPath(int source, int destination) {
+    unsigned char *visited = (unsigned char *)calloc((size_t)N / 8 + 1, 1);
+    long capacity = 1024, depth = 0;
+    int *path = (int *)malloc(capacity * sizeof(int)); // The cities of the current path
+    long *next = (long *)malloc(capacity * sizeof(long)); // The next neighbor to try for each city of the path
+    int i, found = 0;
+
+    // Mark the source city as visited
+    visited[source / 8] |= 1 << (source % 8);
+    path[0] = source;
+    next[0] = rowStart[source];
+    depth = 1;
+    found = source == destination;
+
+    long steps = 0;
+    while (!found && depth > 0) {
+        int city = path[depth - 1];
+
+        // Give up once the time limit has passed
+        if ((++steps & 0xFFFF) == 0 && deadlinePassed()) {
+            found = -1;
+            break;
+        }
+
+        // Backtrack once all the neighbors of the city have been tried
+        if (next[depth - 1] == rowStart[city + 1]) {
+            depth--;
+            continue;
+        }
+
+        int neighbor = adjacency[next[depth - 1]++];
+        if (visited[neighbor / 8] & (1 << (neighbor % 8)))
+            continue;
+        visited[neighbor / 8] |= 1 << (neighbor % 8);
+
+        if (depth == capacity) {
+            capacity *= 2;
+            path = (int *)realloc(path, capacity * sizeof(int));
+            next = (long *)realloc(next, capacity * sizeof(long));
+        }
+        path[depth] = neighbor;
+        next[depth] = rowStart[neighbor];
+        depth++;
+        found = neighbor == destination;
+    }
+
+    // If the destination city is reached, print the path
+    if (found == 1) {
+        printf("Yes Path Exists!\n");
+        for (i = 0; i < depth; i++) {
+            printf("%d", path[i]);
+            if (i < depth - 1) {
+                printf("=>");
+            }
+        }
+        printf("\n");
+    }
+
+    free(visited);
+    free(path);
+    free(next);
+    return found;
+}
+
+int chooseDirection(const int *frontier, int frontierSize, int previousSize, long unexplored, int bottomUp) {
+    long frontierEdges = 0;
+    int i;
+
+    for (i = 0; i < frontierSize; i++)
+        frontierEdges += rowStart[frontier[i] + 1] - rowStart[frontier[i]];
+    if (!bottomUp && frontierSize > previousSize && frontierEdges > unexplored / DIRECTION_ALPHA)
+        return 1;
+    if (bottomUp && frontierSize < N / DIRECTION_BETA)
+        return 0;
+    return bottomUp;
+}
+
+int bottomUpLevel(const int *frontier, int frontierSize, const int *seen, int mark, int *from, int *next,
+                  uint64_t *inFrontier) {
+    int nextSize = 0, i, w;
+    long e;
+
+    for (i = 0; i < frontierSize; i++)
+        inFrontier[frontier[i] / 64] |= (uint64_t)1 << (frontier[i] % 64);
+
+    // The connections into a city are in ascending order, so the first one found is from the smallest city
+    for (w = 0; w < N; w++) {
+        if (seen[w] == mark)
+            continue;
+        for (e = incomingStart[w]; e < incomingStart[w + 1]; e++) {
+            int v = incoming[e];
+            if (inFrontier[v / 64] & ((uint64_t)1 << (v % 64))) {
+                from[w] = v;
+                next[nextSize++] = w;
+                break;
+            }
+        }
+    }
+
+    for (i = 0; i < frontierSize; i++)
+        inFrontier[frontier[i] / 64] = 0;
+    return nextSize;
+}
+
+int findFewestHops(int source, int destination) {
+    size_t words = ((size_t)N + 63) / 64;
+    int *parent = (int *)malloc((size_t)N * sizeof(int)); // The city each city was reached from
+    int *seen = (int *)malloc((size_t)N * sizeof(int)); // The source for the cities reached, -1 for the others
+    int *frontier = (int *)malloc((size_t)N * sizeof(int)); // The cities of the current level
+    int *next = (int *)malloc((size_t)N * sizeof(int)); // The cities of the next level
+    uint64_t *inFrontier = (uint64_t *)calloc(words + 1, sizeof(uint64_t)); // The current level as bits
+    int frontierSize = 1, previousSize = 0, nextSize, level, bottomUp = 0, found, i;
+    long unexplored = edgeCount, e; // The connections into the cities not reached yet
+
+    buildIncoming();
+    for (i = 0; i < N; i++)
+        seen[i] = -1;
+    seen[source] = source;
+    parent[source] = source;
+    frontier[0] = source;
+    unexplored -= incomingStart[source + 1] - incomingStart[source];
+    found = source == destination;
+
+    for (level = 1; !found && frontierSize > 0; level++) {
+        if (deadlinePassed()) {
+            found = -1;
+            break;
+        }
+
+        bottomUp = chooseDirection(frontier, frontierSize, previousSize, unexplored, bottomUp);
+        nextSize = 0;
+        if (!bottomUp) {
+            for (i = 0; i < frontierSize; i++) {
+                int v = frontier[i];
+                for (e = rowStart[v]; e < rowStart[v + 1]; e++) {
+                    int w = adjacency[e];
+                    if (seen[w] != source) {
+                        seen[w] = source;
+                        parent[w] = v;
+                        next[nextSize++] = w;
+                    }
+                }
+            }
+        }
+        else {
+            nextSize = bottomUpLevel(frontier, frontierSize, seen, source, parent, next, inFrontier);
+        }
+        for (i = 0; i < nextSize; i++) {
+            seen[next[i]] = source;
+            unexplored -= incomingStart[next[i] + 1] - incomingStart[next[i]];
+        }
+
+        if (statsOutput)
+            fprintf(stderr, "Level %d: %s, %d cities in the frontier, %d found\n", level,
+                    bottomUp ? "bottom-up" : "top-down", frontierSize, nextSize);
+        found = seen[destination] == source;
+
+        int *swap = frontier;
+        frontier = next;
+        next = swap;
+        previousSize = frontierSize;
+        frontierSize = nextSize;
+    }
+
+    // The route is followed back from the destination, then printed from the source
+    if (found == 1) {
+        int length = 0, city;
+        for (city = destination; city != source; city = parent[city])
+            next[length++] = city;
+        printf("Yes Path Exists!\n");
+        printf("%d", source);
+        while (length > 0)
+            printf("=>%d", next[--length]);
+        printf("\n");
+    }
+
+    free(parent);
+    free(seen);
+    free(frontier);
+    free(next);
+    free(inFrontier);
+    return found;
+}
+
+
+void implementI (char **filename) {
+    *filename = optarg;
+    
+    // Load the network, which stays loaded for the other options
+    loadGraph(*filename);
+
+    int i,j;
+    long e;
+
+    // A list of connections is printed as the neighbors of each city
+    if (cityMatrix == NULL) {
+        printf("Neighbor table\n");
+        for (i = 0; i < N; i++) {
+            printf("%d:", i);
+            for (e = rowStart[i]; e < rowStart[i + 1]; e++)
+                printf(" %d", adjacency[e]);
+            printf("\n");
+        }
+        printf("\n");
+        return;
+    }
+
+    unsigned char *bits = (unsigned char *)malloc(((size_t)N + 7) / 8 + 1);
+    char *text = (char *)malloc(2 * (size_t)N + 1);
+
+    // Print the adjacency matrix
+    printf("Neighbor table\n");
+    for (i = 0; i < N; i++) {
+        if (packRow(cityMatrix[i], bits) == 0) {
+            writeBitRow(stdout, bits, text, 1);
+            continue;
+        }
+
+        // Rows with other values than 0 and 1 are printed cell by cell
+        for (j = 0; j < N; j++) {
+            printf("%d ", cityMatrix[i][j]);
+        }
+        printf("\n");
+    }
+    printf("\n");
+
+    free(bits);
+    free(text);
+}
+
+
+void implementR (char **filename) {
+    int sourceCity = -1, destinationCity = -1;
+
+    // A city can also be given as the point "<latitude>:<longitude>" nearest to it
+    if (strchr(optarg, ':') != NULL) {
+        double point[4];
+        if (sscanf(optarg, "%lf:%lf,%lf:%lf", &point[0], &point[1], &point[2], &point[3]) == 4) {
+            loadGraph(*filename);
+            loadCoordinates();
+            sourceCity = snapCity(point[0], point[1]);
+            destinationCity = snapCity(point[2], point[3]);
+        }
+        else if (sscanf(optarg, "%lf:%lf,%d", &point[0], &point[1], &destinationCity) == 3) {
+            loadGraph(*filename);
+            loadCoordinates();
+            sourceCity = snapCity(point[0], point[1]);
+        }
+        else if (sscanf(optarg, "%d,%lf:%lf", &sourceCity, &point[2], &point[3]) == 3) {
+            loadGraph(*filename);
+            loadCoordinates();
+            destinationCity = snapCity(point[2], point[3]);
+        }
+        else {
+            fprintf(stderr, "Invalid source and destination cities: %s\n", optarg);
+            exit(EXIT_FAILURE);
+        }
+    }
+    // sscanf(optarg, "%d,%d", &sourceCity, &destinationCity);
+    else if (sscanf(optarg, "%d,%d", &sourceCity, &destinationCity) != 2) {
+        fprintf(stderr, "Invalid source and destination cities: %s\n", optarg);
+        exit(EXIT_FAILURE);
+    }
+
+    loadGraph(*filename);
+
+    if (sourceCity < 0 || sourceCity >= N || destinationCity < 0 || destinationCity >= N) {
+        fprintf(stderr, "Invalid source and destination cities: %s\n", optarg);
+        exit(EXIT_FAILURE);
+    }
+
+    startDeadline();
+    int found;
+    if (alternativeRoutes > 0)
+        found = findAlternatives(sourceCity, destinationCity, alternativeRoutes);
+    else if (routeTable != NULL && !astarRoute)
+        found = followRoute(sourceCity, destinationCity);
+    else if (hopsOnly && !astarRoute)
+        found = findFewestHops(sourceCity, destinationCity);
+    else
+        found = astarRoute ? findRoute(sourceCity, destinationCity) : findPath(sourceCity, destinationCity);
+    if (found == 0)
+        printf("No Path Exists!\n");
+    else if (found < 0)
+        reportDeadline("the path search was stopped before reaching the destination");
+}
+
+void implementP (char **filename) {
+
+    loadGraph(*filename);
+
+    planClosure(N, 1);
+    startDeadline();
+    startProgress();
+
+    // Calculate the transitive closure
+    printf("R* table\n");
+    long pairs;
+    if (matrixOutput)
+        pairs = writeClosureMatrix(stdout, 0, N);
+    else
+        pairs = calculateTransitiveClosure(cityMatrix, NULL, 0);
+    stopProgress();
+    reportDirections();
+
+    char partial[256];
+    snprintf(partial, sizeof(partial), "the R* table has the first %ld pairs", pairs);
+    reportDeadline(partial);
+}
+
+void implementFacilities (char **filename, const char *list) {
+    loadGraph(*filename);
+
+    int count, i;
+    int *facility = parseCityList(list, &count);
+
+    // The facilities are sorted so that the smallest one wins a tie
+    if (facility == NULL) {
+        fprintf(stderr, "Invalid facilities: %s\n", list);
+        exit(EXIT_FAILURE);
+    }
+    qsort(facility, count, sizeof(int), compareCities);
+
+    long *reverseStart;
+    int *reverseAdjacency, *reverseWeight;
+    buildReverse(&reverseStart, &reverseAdjacency, &reverseWeight);
+
+    int *nearest = (int *)malloc((size_t)N * sizeof(int)); // The facility of each city, -1 if none
+    long long *distance = (long long *)malloc((size_t)N * sizeof(long long));
+    long e, steps = 0;
+    for (i = 0; i < N; i++)
+        nearest[i] = -1;
+
+    startDeadline();
+    if (reverseWeight == NULL || hopsOnly) {
+        // Breadth first search: every round of the queue is in the order of the facilities
+        int *queue = (int *)malloc((size_t)N * sizeof(int));
+        int head = 0, tail = 0;
+
+        for (i = 0; i < count; i++) {
+            if (nearest[facility[i]] < 0) {
+                nearest[facility[i]] = facility[i];
+                distance[facility[i]] = 0;
+                queue[tail++] = facility[i];
+            }
+        }
+        while (head < tail) {
+            int v = queue[head++];
+            if ((++steps & 0xFFFF) == 0 && deadlinePassed())
+                break;
+
+            for (e = reverseStart[v]; e < reverseStart[v + 1]; e++) {
+                int u = reverseAdjacency[e];
+                if (nearest[u] < 0) {
+                    nearest[u] = nearest[v];
+                    distance[u] = distance[v] + 1;
+                    queue[tail++] = u;
+                }
+            }
+        }
+        free(queue);
+    }
+    else {
+        // Dijkstra's algorithm, with the facility as the second key of the heap
+        Heap heap = {NULL, 0, 0};
+        HeapItem item;
+
+        for (i = 0; i < count; i++) {
+            nearest[facility[i]] = facility[i];
+            distance[facility[i]] = 0;
+            heapPush(&heap, 0, facility[i], facility[i]);
+        }
+        while (heapPop(&heap, &item)) {
+            int v = item.city;
+            if (item.distance != distance[v] || item.tag != nearest[v])
+                continue;
+            if ((++steps & 0xFFFF) == 0 && deadlinePassed())
+                break;
+
+            for (e = reverseStart[v]; e < reverseStart[v + 1]; e++) {
+                int u = reverseAdjacency[e];
+                if (reverseWeight[e] < 0) {
+                    fprintf(stderr, "Error: The connection %d -> %d has a negative cost.\n", u, v);
+                    exit(EXIT_FAILURE);
+                }
+
+                long long d = item.distance + reverseWeight[e];
+                if (nearest[u] < 0 || d < distance[u] || (d == distance[u] && item.tag < nearest[u])) {
+                    nearest[u] = item.tag;
+                    distance[u] = d;
+                    heapPush(&heap, d, u, item.tag);
+                }
+            }
+        }
+        free(heap.items);
+    }
+
+    printf("Nearest facility\n");
+    for (i = 0; i < N; i++) {
+        if (nearest[i] < 0)
+            printf("%d: none\n", i);
+        else
+            printf("%d: %d %lld\n", i, nearest[i], distance[i]);
+    }
+    reportDeadline("the cities not reached yet have no facility");
+
+    free(facility);
+    free(nearest);
+    free(distance);
+    free(reverseStart);
+    free(reverseAdjacency);
+    free(reverseWeight);
+}
+
+int *parseCityList(const char *list, int *count) {
+    int capacity = 16;
+    int *cities = (int *)malloc(capacity * sizeof(int));
+    const char *p = list;
+
+    *count = 0;
+    while (*p != '\0') {
+        char *end;
+        long first = strtol(p, &end, 10), last;
+        if (end == p || first < 0 || first >= N)
+            break;
+
+        last = first;
+        if (*end == '-') {
+            p = end + 1;
+            last = strtol(p, &end, 10);
+            if (end == p || last < first || last >= N)
+                break;
+        }
+        if (*end != ',' && *end != '\0')
+            break;
+
+        for (; first <= last; first++) {
+            if (*count == capacity) {
+                capacity *= 2;
+                cities = (int *)realloc(cities, capacity * sizeof(int));
+            }
+            cities[(*count)++] = (int)first;
+        }
+        p = *end == ',' ? end + 1 : end;
+    }
+
+    if (*p != '\0' || *count == 0) {
+        free(cities);
+        return NULL;
+    }
+    return cities;
+}
+
+void *tableThread(void *arg) {
+    TableJob *job = (TableJob *)arg;
+    long long *distance = (long long *)malloc(((size_t)N + 1) * sizeof(long long));
+    int *touched = (int *)malloc(((size_t)N + 1) * sizeof(int)); // The cities reached, and the queue of the breadth first search
+    long e;
+    int i, k;
+
+    for (i = 0; i < N; i++)
+        distance[i] = -1;
+
+    for (i = job->thread; i < job->originCount && !deadlinePassed(); i += job->threads) {
+        int origin = job->origin[i], reached = 0, left = job->goalCities, head = 0;
+        Heap heap = {NULL, 0, 0};
+        HeapItem item;
+
+        distance[origin] = 0;
+        touched[reached++] = origin;
+        if (job->costs != NULL)
+            heapPush(&heap, 0, origin, 0);
+
+        while (left > 0) {
+            int v;
+
+            // The next city settled, in order of distance
+            if (job->costs != NULL) {
+                if (!heapPop(&heap, &item))
+                    break;
+                if (item.distance != distance[item.city])
+                    continue;
+                v = item.city;
+            }
+            else {
+                if (head == reached)
+                    break;
+                v = touched[head++];
+            }
+
+            // Fill in the slots of a goal
+            if (job->slotHead[v] >= 0) {
+                left--;
+                for (k = job->slotHead[v]; k >= 0; k = job->slotNext[k]) {
+                    if (job->forward)
+                        job->table[(size_t)i * job->goalCount + k] = distance[v];
+                    else
+                        job->table[(size_t)k * job->originCount + i] = distance[v];
+                }
+            }
+
+            for (e = job->start[v]; e < job->start[v + 1]; e++) {
+                int w = job->list[e];
+                long long d = distance[v] + (job->costs != NULL ? job->costs[e] : 1);
+                if (distance[w] >= 0 && (job->costs == NULL || d >= distance[w]))
+                    continue;
+
+                if (distance[w] < 0)
+                    touched[reached++] = w;
+                distance[w] = d;
+                if (job->costs != NULL)
+                    heapPush(&heap, d, w, 0);
+            }
+        }
+
+        // Only the cities reached need to be cleared for the next search
+        for (k = 0; k < reached; k++)
+            distance[touched[k]] = -1;
+        free(heap.items);
+    }
+
+    free(distance);
+    free(touched);
+    return NULL;
+}
+
+void implementTable (char **filename, const char *lists) {
+    loadGraph(*filename);
+
+    const char *slash = strchr(lists, '/');
+    int sourceCount = 0, targetCount = 0, *sources = NULL, *targets = NULL;
+    if (slash != NULL) {
+        char *first = (char *)malloc(slash - lists + 1);
+        memcpy(first, lists, slash - lists);
+        first[slash - lists] = '\0';
+        sources = parseCityList(first, &sourceCount);
+        targets = parseCityList(slash + 1, &targetCount);
+        free(first);
+    }
+    if (sources == NULL || targets == NULL) {
+        fprintf(stderr, "Invalid sources and targets: %s (use <sources>/<targets>, such as 0-999/5,7,9)\n", lists);
+        exit(EXIT_FAILURE);
+    }
+
+    long *reverseStart = NULL;
+    int *reverseAdjacency = NULL, *reverseWeight = NULL;
+    int forward = sourceCount <= targetCount, k;
+    if (!forward)
+        buildReverse(&reverseStart, &reverseAdjacency, &reverseWeight);
+
+    // The goals of the searches, with a list of slots for a city given more than once
+    const int *goal = forward ? targets : sources;
+    int goalCount = forward ? targetCount : sourceCount, goalCities = 0;
+    int *slotHead = (int *)malloc(((size_t)N + 1) * sizeof(int));
+    int *slotNext = (int *)malloc((goalCount + 1) * sizeof(int));
+    for (k = 0; k < N; k++)
+        slotHead[k] = -1;
+    for (k = goalCount - 1; k >= 0; k--) {
+        if (slotHead[goal[k]] < 0)
+            goalCities++;
+        slotNext[k] = slotHead[goal[k]];
+        slotHead[goal[k]] = k;
+    }
+
+    long long *table = (long long *)malloc(((size_t)sourceCount * targetCount + 1) * sizeof(long long));
+    size_t cell;
+    for (cell = 0; cell < (size_t)sourceCount * targetCount; cell++)
+        table[cell] = -1;
+
+    long processors = sysconf(_SC_NPROCESSORS_ONLN);
+    int threads = processors > 0 ? (int)processors : 1;
+    int origins = forward ? sourceCount : targetCount;
+    if (threads > origins)
+        threads = origins;
+
+    TableJob *job = (TableJob *)malloc(threads * sizeof(TableJob));
+    pthread_t *thread = (pthread_t *)malloc(threads * sizeof(pthread_t));
+    const int *costs = forward ? weight : reverseWeight;
+
+    startDeadline();
+    for (k = 0; k < threads; k++) {
+        job[k].origin = forward ? sources : targets;
+        job[k].originCount = origins;
+        job[k].slotHead = slotHead;
+        job[k].slotNext = slotNext;
+        job[k].goalCount = goalCount;
+        job[k].goalCities = goalCities;
+        job[k].start = forward ? rowStart : reverseStart;
+        job[k].list = forward ? adjacency : reverseAdjacency;
+        job[k].costs = hopsOnly ? NULL : costs;
+        job[k].forward = forward;
+        job[k].thread = k;
+        job[k].threads = threads;
+        job[k].table = table;
+
+        if (pthread_create(&thread[k], NULL, tableThread, &job[k]) != 0) {
+            fprintf(stderr, "Error: Unable to start the thread for the distance table.\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    for (k = 0; k < threads; k++)
+        pthread_join(thread[k], NULL);
+
+    int i, j;
+    if (binaryTable) {
+        // "CLDT", the numbers of sources and targets, their cities, then the distances by rows, little endian
+        char *name = outputName(*filename, ".dist");
+        FILE *file = fopen(name, "wb");
+        unsigned char bytes[8];
+        if (file == NULL) {
+            fprintf(stderr, "Error opening the output file \n");
+            exit(EXIT_FAILURE);
+        }
+
+        fwrite("CLDT", 1, 4, file);
+        writeLE32(bytes, sourceCount);
+        fwrite(bytes, 1, 4, file);
+        writeLE32(bytes, targetCount);
+        fwrite(bytes, 1, 4, file);
+        for (i = 0; i < sourceCount; i++) {
+            writeLE32(bytes, sources[i]);
+            fwrite(bytes, 1, 4, file);
+        }
+        for (j = 0; j < targetCount; j++) {
+            writeLE32(bytes, targets[j]);
+            fwrite(bytes, 1, 4, file);
+        }
+        for (cell = 0; cell < (size_t)sourceCount * targetCount; cell++) {
+            uint64_t value = (uint64_t)table[cell];
+            writeLE32(bytes, (unsigned long)(value & 0xFFFFFFFFUL));
+            writeLE32(bytes + 4, (unsigned long)(value >> 32));
+            fwrite(bytes, 1, 8, file);
+        }
+        fclose(file);
+        printf("Saving %s...\n", name);
+        free(name);
+    }
+    else {
+        printf("Distance table\n");
+        for (j = 0; j < targetCount; j++)
+            printf(j == 0 ? "%d" : " %d", targets[j]);
+        printf("\n");
+        for (i = 0; i < sourceCount; i++) {
+            printf("%d:", sources[i]);
+            for (j = 0; j < targetCount; j++) {
+                if (table[(size_t)i * targetCount + j] < 0)
+                    printf(" -");
+                else
+                    printf(" %lld", table[(size_t)i * targetCount + j]);
+            }
+            printf("\n");
+        }
+    }
+    reportDeadline("the distances not found yet are missing");
+
+    free(job);
+    free(thread);
+    free(table);
+    free(slotHead);
+    free(slotNext);
+    free(sources);
+    free(targets);
+    free(reverseStart);
+    free(reverseAdjacency);
+    free(reverseWeight);
+}
+
+void heapPush(Heap *heap, long long distance, int city, int tag) {
+    HeapItem item = {distance, city, tag};
+    long i;
+
+    if (heap->size == heap->capacity) {
+        heap->capacity = heap->capacity > 0 ? 2 * heap->capacity : 1024;
+        heap->items = (HeapItem *)realloc(heap->items, heap->capacity * sizeof(HeapItem));
+        if (heap->items == NULL) {
+            fprintf(stderr, "Error: Not enough memory for the search.\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    // Move the new entry up past the entries that come after it
+    for (i = heap->size++; i > 0; i = (i - 1) / 2) {
+        HeapItem *parent = &heap->items[(i - 1) / 2];
+        if (parent->distance < item.distance ||
+            (parent->distance == item.distance && (parent->tag < item.tag ||
+             (parent->tag == item.tag && parent->city <= item.city))))
+            break;
+        heap->items[i] = *parent;
+    }
+    heap->items[i] = item;
+}
+
+int heapPop(Heap *heap, HeapItem *item) {
+    long i = 0, child;
+
+    if (heap->size == 0)
+        return 0;
+
+    *item = heap->items[0];
+    HeapItem last = heap->items[--heap->size];
+
+    // Move the last entry down past the entries that come before it
+    while ((child = 2 * i + 1) < heap->size) {
+        HeapItem *c = &heap->items[child];
+        if (child + 1 < heap->size) {
+            HeapItem *d = &heap->items[child + 1];
+            if (d->distance < c->distance || (d->distance == c->distance &&
+                (d->tag < c->tag || (d->tag == c->tag && d->city < c->city)))) {
+                child++;
+                c = d;
+            }
+        }
+        if (last.distance < c->distance || (last.distance == c->distance &&
+            (last.tag < c->tag || (last.tag == c->tag && last.city <= c->city))))
+            break;
+        heap->items[i] = *c;
+        i = child;
+    }
+    heap->items[i] = last;
+    return 1;
+}
+
+void implementEncode (char **filename, const char *name) {
+    int encoding = parseEncoding(name);
+    int i,j, costs = 0;
+    long e;
+
+    if (encoding < 0) {
+        fprintf(stderr, "Invalid encoding: %s (use plain, bits, hex, rle, edges or weighted)\n", name);
+        exit(EXIT_FAILURE);
+    }
+
+    loadGraph(*filename);
+
+    // Bit strings and hex digits can only hold connections, not other values, whether the
+    // network was read as a matrix or as a weighted edge list
+    if (encoding == ENC_BITS || encoding == ENC_HEX) {
+        if (cityMatrix != NULL) {
+            for (i = 0; i < N; i++) {
+                for (j = 0; j < N; j++)
+                    costs |= cityMatrix[i][j] != 0 && cityMatrix[i][j] != 1;
+            }
+        }
+        else if (weight != NULL) {
+            for (e = 0; e < edgeCount; e++)
+                costs |= weight[e] != 1;
+        }
+        if (costs) {
+            fprintf(stderr, "Error: The %s encoding only holds 0 and 1 values.\n", name);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    char *encoded = (char *)malloc(strlen(*filename) + strlen(name) + 2);
+    sprintf(encoded, "%s.%s", *filename, name);
+
+    FILE *file = fopen(encoded, "w");
+    if (file == NULL) {
+        fprintf(stderr, "Error opening the output file \n");
+        exit(EXIT_FAILURE);
+    }
+
+    writeEncodedMatrix(file, encoding);
+    fclose(file);
+    printf("Saving %s...\n", encoded);
+
+    free(encoded);
+}
+
+void implementO (char **filename){
+
+    if (shardCount > 1) {
+        loadGraph(*filename);
+        planClosure(N, shardCount < N ? shardCount : (N > 0 ? N : 1));
+        startDeadline();
+        startProgress();
+
+        writeShards(*filename, shardCount);
+        stopProgress();
+        reportDirections();
+        return;
+    }
+
+    char suffix[32];
+    outputSuffix(suffix, sizeof(suffix), -1);
+    char *outputfile = outputName(*filename, suffix);
+   
+    Output *output = openOutput(outputfile);
+
+    loadGraph(*filename);
+    planClosure(N, 1);
+    startDeadline();
+    startProgress();
+
+    long pairs;
+    if (arrowOutput) {
+        pairs = writeClosure(output, 0, N);
+    }
+    else if (matrixOutput) {
+        // The matrix has the layout of an input file, so that -i can read it back
+        fprintf(output->stream, "%d\n", N);
+        pairs = writeClosure(output, 0, N);
+    }
+    else {
+        fprintf(output->stream, "R* table\n");
+        pairs = calculateTransitiveClosure(cityMatrix, output->stream, 1);
+    }
+    stopProgress();
+    reportDirections();
+
+    closeOutput(output);
+    printf("Saving %s...\n", outputfile);
+
+    char partial[256];
+    snprintf(partial, sizeof(partial), "%s has the first %ld pairs", outputfile, pairs);
+    reportDeadline(partial);
+    free(outputfile);
+}
+
+char *outputName(const char *filename, const char *suffix) {
+    size_t length = strlen(filename);
+
+    // A compressed input gives the same output names as the original file
+    if (length > 4 && strcmp(filename + length - 4, ".clz") == 0)
+        length -= 4;
+
+    char *name = (char *)malloc(length + strlen(suffix) + 5); // 5 = length of "out-" plus null terminator
+    strcpy(name, "out-");
+    strncat(name, filename, length);
+    strcat(name, suffix);
+    return name;
+}
+
+// The part of the R* table written by one shard thread
+typedef struct {
+    int first; // The first source city of the shard
+    int last; // One past the last source city of the shard
+    char *path; // The name of the shard file
+    long pairs; // The number of pairs written
+} Shard;
+
+// Thread body that calculates and writes the rows of one shard
+void *writeShard(void *arg) {
+    Shard *shard = (Shard *)arg;
+
+    Output *output = openOutput(shard->path);
+    shard->pairs = writeClosure(output, shard->first, shard->last);
+    closeOutput(output);
+    return NULL;
+}
+
+void writeShards(const char *filename, int shards) {
+    int k;
+    char suffix[32];
+
+    // There is no point in having shards without any source city
+    if (shards > N)
+        shards = N > 0 ? N : 1;
+
+    Shard *shard = (Shard *)malloc(shards * sizeof(Shard));
+    pthread_t *thread = (pthread_t *)malloc(shards * sizeof(pthread_t));
+
+    for (k = 0; k < shards; k++) {
+        shard[k].first = (int)((long)k * N / shards);
+        shard[k].last = (int)((long)(k + 1) * N / shards);
+        outputSuffix(suffix, sizeof(suffix), k);
+        shard[k].path = outputName(filename, suffix);
+        shard[k].pairs = 0;
+
+        if (pthread_create(&thread[k], NULL, writeShard, &shard[k]) != 0) {
+            fprintf(stderr, "Error: Unable to start the thread for shard %d.\n", k);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    for (k = 0; k < shards; k++)
+        pthread_join(thread[k], NULL);
+
+    // The manifest lists every shard with its range of source cities and number of pairs
+    char *manifest = outputName(filename, ".manifest");
+    FILE *file = fopen(manifest, "w");
+    if (file == NULL) {
+        fprintf(stderr, "Error opening the output file \n");
+        exit(EXIT_FAILURE);
+    }
+
+    fprintf(file, "R* table\n");
+    fprintf(file, "cities %d\n", N);
+    fprintf(file, "shards %d\n", shards);
+    for (k = 0; k < shards; k++) {
+        fprintf(file, "%s %d %d %ld\n", shard[k].path, shard[k].first, shard[k].last, shard[k].pairs);
+        printf("Saving %s...\n", shard[k].path);
+        free(shard[k].path);
+    }
+    fclose(file);
+    printf("Saving %s...\n", manifest);
+
+    // The manifest gives the pairs each shard has, so a partial run can still be used
+    char partial[256];
+    snprintf(partial, sizeof(partial), "the shards have the pairs listed in %s", manifest);
+    reportDeadline(partial);
+
+    free(manifest);
+    free(shard);
+    free(thread);
+}
+
+
+// Function to calculate the transitive closure
+long calculateTransitiveClosure(int **cityMatrix, FILE *outputFile, int printToFile) {
+    return closeRange(cityMatrix, 0, N, printPair, printToFile ? outputFile : stdout);
+}
+
+// Function that prints a pair of the R* table
+void printPair(void *context, int source, int destination, int round) {
+    (void)round;
+    fprintf((FILE *)context, "%d -> %d\n", source, destination);
+}
+
+void outputSuffix(char *suffix, size_t size, int shard) {
+    suffix[0] = '\0';
+    if (shard >= 0)
+        snprintf(suffix, size, ".%03d", shard);
+    if (arrowOutput)
+        strncat(suffix, ".arrows", size - strlen(suffix) - 1);
+    if (compressOutput)
+        strncat(suffix, ".clz", size - strlen(suffix) - 1);
+}
+
+long writeClosure(Output *output, int first, int last) {
+    if (matrixOutput)
+        return writeClosureMatrix(output->stream, first, last);
+    if (!arrowOutput)
+        return closeRange(cityMatrix, first, last, printPair, output->stream);
+
+    ArrowWriter *writer = createArrowWriter(output->stream, arrowOutput == 2);
+    long pairs = closeRange(cityMatrix, first, last, writeArrowPair, writer);
+    finishArrowWriter(writer);
+    return pairs;
+}
+
+// Function to calculate the transitive closure of a range of source cities
+long closeRows(int **cityMatrix, int first, int last, PairFunction emit, void *context) {
+
+    int rows = last - first;
+    long pairs = 0;
+
+     // Create a new matrix for the rows of the transitive closure (initialize it as a copy of the adjacency matrix)
+    int** transitiveClosure = createMatrix(rows);
+   
+    int i,j;
+    for (i = 0; i < rows; i++) {
+        for (j = 0; j < N; j++) {
+            transitiveClosure[i][j] = cityMatrix[first + i][j];
+        }
+    }
+
+    int u,w,v;
+    // Print the transitive closure after initialization
+    for (u = first; u < last; u++) {
+        for (w = 0; w < N; w++) {
+            if (transitiveClosure[u - first][w] != 0) {
+                emit(context, u, w, 0);
+                pairs++;
+            }
+        }
+    }
+    PROGRESS_ADD(progressPairs, pairs);
+
+    int **previous = createMatrix(rows);
+    char *complete = (char *)calloc(rows + 1, 1); // Whether a row found nothing new in a round
+
+    int round = 0;
+    int repeat = 1; // A flag to check for changes
+    while (repeat && !deadlinePassed()) {
+        repeat = 0; // Reset the flag
+        round++;
+
+        // Copy the current transitive closure into previous
+        for (i = 0; i < rows; i++) {
+            for (w = 0; w < N; w++) {
+                previous[i][w] = transitiveClosure[i][w];
+            }
+        }
+
+        PROGRESS_SET(progressRound, round);
+        for (u = first; u < last && !deadlinePassed(); u++) {
+            long rowPairs = pairs;
+            PROGRESS_ADD(progressSteps, 1);
+            for (v = 0; v < N; v++) {
+                if (previous[u - first][v]) {
+                    for (w = 0; w < N; w++) {
+                        if (cityMatrix[v][w] && !transitiveClosure[u - first][w] && u != w) {
+                            transitiveClosure[u - first][w] = 1;
+                            repeat = 1; // Set the flag to indicate a change
+
+                            // Print the newly added connection
+                            emit(context, u, w, round);
+                            pairs++;
+                        }
+                    }
+                }
+            }
+
+            // A row without new pairs in a round is complete
+            PROGRESS_ADD(progressPairs, pairs - rowPairs);
+            if (pairs == rowPairs && !complete[u - first]) {
+                complete[u - first] = 1;
+                PROGRESS_ADD(progressRows, 1);
+            }
+        }
+    }
+    free(complete);
+
+    // Free dynamically allocated memory
+    freeMatrix(transitiveClosure, rows);
+    freeMatrix(previous, rows);
+    return pairs;
+}
+
+// Thread body that compresses the text coming through the pipe of an output
+void *compressOutputThread(void *arg) {
+    Output *output = (Output *)arg;
+    clzCompress(output->pipe, output->file);
+    return NULL;
+}
+
+Output *openOutput(const char *path) {
+    Output *output = (Output *)malloc(sizeof(Output));
+
+    output->file = fopen(path, "w+");
+    if (output->file == NULL) {
+        fprintf(stderr, "Error opening the output file %s\n", path);
+        exit(EXIT_FAILURE);
+    }
+
+    if (!compressOutput) {
+        output->stream = output->file;
+        output->pipe = NULL;
+        return output;
+    }
+
+    int fds[2];
+    if (pipe(fds) != 0) {
+        fprintf(stderr, "Error: Unable to create the compression pipe.\n");
+        exit(EXIT_FAILURE);
+    }
+    output->pipe = fdopen(fds[0], "r");
+    output->stream = fdopen(fds[1], "w");
+
+    if (pthread_create(&output->thread, NULL, compressOutputThread, output) != 0) {
+        fprintf(stderr, "Error: Unable to start the compression thread.\n");
+        exit(EXIT_FAILURE);
+    }
+    return output;
+}
+
+void closeOutput(Output *output) {
+    if (output->pipe != NULL) {
+        // Closing the write end lets the compressor see the end of the text
+        fclose(output->stream);
+        pthread_join(output->thread, NULL);
+        fclose(output->pipe);
+    }
+
+    if (fclose(output->file) != 0) {
+        fprintf(stderr, "Error: Unable to write the output file.\n");
+        exit(EXIT_FAILURE);
+    }
+    free(output);
+}
+
+// Function to write a 4-byte little endian number
+void writeLE32(unsigned char *dst, unsigned long value) {
+    dst[0] = value & 0xff;
+    dst[1] = (value >> 8) & 0xff;
+    dst[2] = (value >> 16) & 0xff;
+    dst[3] = (value >> 24) & 0xff;
+}
+
+// Function to read a 4-byte little endian number
+unsigned long readLE32(const unsigned char *src) {
+    return src[0] | ((unsigned long)src[1] << 8) | ((unsigned long)src[2] << 16) | ((unsigned long)src[3] << 24);
+}
+
+// Function to write a length that did not fit into its nibble
+unsigned char *writeLength(unsigned char *op, int length) {
+    while (length >= 255) {
+        *op++ = 255;
+        length -= 255;
+    }
+    *op++ = (unsigned char)length;
+    return op;
+}
+
+// Function to find the earlier position with the same 4 bytes as a position, -1 for none, and remember the position
+int clzFindMatch(const unsigned char *src, int *table, int ip) {
+    unsigned long sequence = readLE32(src + ip);
+    int hash = (int)(((sequence * 2654435761UL) & 0xffffffffUL) >> (32 - CLZ_HASH_BITS));
+    int ref = table[hash];
+    table[hash] = ip;
+    return ref >= 0 && ip - ref <= 65535 && readLE32(src + ref) == sequence ? ref : -1;
+}
+
+// Function to find the length of a match, at least 4
+int clzMatchLength(const unsigned char *src, int size, int ref, int ip) {
+    int length = 4;
+    while (ip + length < size && src[ref + length] == src[ip + length])
+        length++;
+    return length;
+}
+
+int clzCompressBlock(const unsigned char *src, int size, unsigned char *dst) {
+    int *table = (int *)malloc(sizeof(int) << CLZ_HASH_BITS);
+    int anchor = 0, ip = 0;
+    unsigned char *op = dst;
+
+    if (table == NULL) {
+        fprintf(stderr, "Error: Not enough memory for the compressor.\n");
+        exit(EXIT_FAILURE);
+    }
+    memset(table, 0xFF, sizeof(int) << CLZ_HASH_BITS);
+
+    while (ip + 4 <= size) {
+        int ref = clzFindMatch(src, table, ip);
+        if (ref < 0) {
+            ip++;
+            continue;
+        }
+        int matchLength = clzMatchLength(src, size, ref, ip);
+
+        // Lazy matching: a longer match starting at the next byte is worth a literal
+        while (ip + 5 <= size) {
+            int nextRef = clzFindMatch(src, table, ip + 1);
+            if (nextRef < 0)
+                break;
+            int nextLength = clzMatchLength(src, size, nextRef, ip + 1);
+            if (nextLength <= matchLength)
+                break;
+            ip++;
+            ref = nextRef;
+            matchLength = nextLength;
+        }
+
+        int literals = ip - anchor;
+        unsigned char *token = op++;
+        *token = (unsigned char)(((literals < 15 ? literals : 15) << 4) | (matchLength - 4 < 15 ? matchLength - 4 : 15));
+        if (literals >= 15)
+            op = writeLength(op, literals - 15);
+        memcpy(op, src + anchor, literals);
+        op += literals;
+
+        *op++ = (ip - ref) & 0xff;
+        *op++ = (ip - ref) >> 8;
+        if (matchLength - 4 >= 15)
+            op = writeLength(op, matchLength - 4 - 15);
+
+        ip += matchLength;
+        anchor = ip;
+    }
+
+    // The last sequence only holds the remaining literals
+    int literals = size - anchor;
+    *op++ = (unsigned char)((literals < 15 ? literals : 15) << 4);
+    if (literals >= 15)
+        op = writeLength(op, literals - 15);
+    memcpy(op, src + anchor, literals);
+    op += literals;
+
+    free(table);
+    return (int)(op - dst);
+}
+
+int clzDecompressBlock(const unsigned char *src, int size, unsigned char *dst, int capacity) {
+    int ip = 0, op = 0;
+
+    while (ip < size) {
+        int token = src[ip++];
+        int length = token >> 4;
+
+        if (length == 15) {
+            int extra;
+            do {
+                if (ip >= size)
+                    return -1;
+                extra = src[ip++];
+                length += extra;
+            } while (extra == 255);
+        }
+        if (length > size - ip || length > capacity - op)
+            return -1;
+        memcpy(dst + op, src + ip, length);
+        ip += length;
+        op += length;
+
+        // The last sequence ends with its literals
+        if (ip == size)
+            break;
+
+        if (ip + 2 > size)
+            return -1;
+        int offset = src[ip] | (src[ip + 1] << 8);
+        ip += 2;
+        if (offset == 0 || offset > op)
+            return -1;
+
+        length = token & 15;
+        if (length == 15) {
+            int extra;
+            do {
+                if (ip >= size)
+                    return -1;
+                extra = src[ip++];
+                length += extra;
+            } while (extra == 255);
+        }
+        length += 4;
+        if (length > capacity - op)
+            return -1;
+
+        // The match may overlap the bytes it produces, so it is copied byte by byte
+        int i;
+        for (i = 0; i < length; i++, op++)
+            dst[op] = dst[op - offset];
+    }
+    return op;
+}
+
+// Function to write a varint, 7 bits per byte with the high bit set on all but the last byte
+unsigned char *writeVarint(unsigned char *op, unsigned long long value) {
+    while (value >= 0x80) {
+        *op++ = (unsigned char)(value | 0x80);
+        value >>= 7;
+    }
+    *op++ = (unsigned char)value;
+    return op;
+}
+
+// Function to read a varint; returns the position after it, or -1 past the end
+int readVarint(const unsigned char *src, int size, int ip, unsigned long long *value) {
+    int shift = 0;
+    *value = 0;
+    while (ip < size && shift < 64) {
+        *value |= (unsigned long long)(src[ip] & 0x7F) << shift;
+        if (!(src[ip++] & 0x80))
+            return ip;
+        shift += 7;
+    }
+    return -1;
+}
+
+// Function to read a city of a pair line, digits without leading zeros; returns the position after it, or -1
+int readPairCity(const unsigned char *src, int size, int ip, long long *city) {
+    int start = ip;
+    *city = 0;
+    while (ip < size && isdigit(src[ip]) && ip - start < 10) {
+        *city = *city * 10 + (src[ip] - '0');
+        ip++;
+    }
+    if (ip == start || (src[start] == '0' && ip - start > 1) || *city > INT_MAX)
+        return -1;
+    return ip;
+}
+
+
+// Function to fold a difference of either sign into a small number
+unsigned long long zigzag(long long value) {
+    return ((unsigned long long)value << 1) ^ (unsigned long long)(value >> 63);
+}
+
+// Function to unfold a difference folded by zigzag
+long long unzigzag(unsigned long long value) {
+    return (long long)(value >> 1) ^ -(long long)(value & 1);
+}
+
+int pairEncode(const unsigned char *src, int size, unsigned char *dst, int capacity) {
+    const unsigned char *newline = (const unsigned char *)memchr(src, '\n', size);
+    int pairs = 0, ip, end, first, last, k;
+
+    if (newline == NULL)
+        return -1;
+
+    // A pair line has at least 7 bytes, "0 -> 1\n"
+    int prefix = (int)(newline - src) + 1;
+    int most = (size - prefix) / 7 + 1;
+    long long *source = (long long *)malloc(2 * (size_t)most * sizeof(long long));
+    long long *destination = source + most;
+    if (source == NULL) {
+        fprintf(stderr, "Error: Not enough memory for the compressor.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    for (ip = prefix; ip < size; ip = end) {
+        end = readPairCity(src, size, ip, &source[pairs]);
+        if (end < 0 || end + 4 > size || memcmp(src + end, " -> ", 4) != 0)
+            break;
+        end = readPairCity(src, size, end + 4, &destination[pairs]);
+        if (end < 0 || end >= size || src[end] != '\n')
+            break;
+        end++;
+        pairs++;
+    }
+
+    // Count the bytes of the destinations as they are and as differences
+    unsigned char scratch[10], *op = dst, *limit = dst + capacity;
+    long long previousSource = 0, previousDestination = 0, absoluteBytes = 0, differenceBytes = 0;
+    for (k = 0; k < pairs; k++) {
+        absoluteBytes += writeVarint(scratch, (unsigned long long)destination[k]) - scratch;
+        differenceBytes += writeVarint(scratch, zigzag(destination[k] - previousDestination)) - scratch;
+        previousDestination = destination[k];
+    }
+    int absolute = absoluteBytes < differenceBytes;
+    previousDestination = 0;
+
+    // The pairs of a source are its difference from the previous source, their number and their destinations
+    if (pairs == 0 || limit - op < prefix + 20) {
+        free(source);
+        return -1;
+    }
+    op = writeVarint(op, (unsigned long long)prefix);
+    memcpy(op, src, prefix);
+    op = writeVarint(op + prefix, (unsigned long long)pairs);
+    *op++ = (unsigned char)absolute;
+    for (first = 0; first < pairs; first = last) {
+        for (last = first + 1; last < pairs && source[last] == source[first]; last++)
+            ;
+        if (limit - op < 20 + 10 * (last - first))
+            break;
+        op = writeVarint(op, zigzag(source[first] - previousSource));
+        op = writeVarint(op, (unsigned long long)(last - first - 1));
+        for (k = first; k < last; k++) {
+            op = writeVarint(op, absolute ? (unsigned long long)destination[k] : zigzag(destination[k] - previousDestination));
+            previousDestination = destination[k];
+        }
+        previousSource = source[first];
+    }
+    free(source);
+
+    if (first < pairs || limit - op < size - ip)
+        return -1;
+    memcpy(op, src + ip, size - ip);
+    op += size - ip;
+    return op - dst < size ? (int)(op - dst) : -1;
+}
+
+int pairDecode(const unsigned char *src, int size, unsigned char *dst, int capacity) {
+    unsigned long long prefix, pairs, step, count;
+    long long source = 0, destination = 0;
+    unsigned char *op = dst;
+    char line[48];
+    int ip = readVarint(src, size, 0, &prefix);
+
+    if (ip < 0 || prefix > (unsigned long long)(size - ip) || prefix > (unsigned long long)capacity)
+        return -1;
+    memcpy(op, src + ip, prefix);
+    op += prefix;
+    if ((ip = readVarint(src, size, ip + (int)prefix, &pairs)) < 0 || ip >= size || src[ip] > 1)
+        return -1;
+    int absolute = src[ip++];
+
+    while (pairs > 0) {
+        if ((ip = readVarint(src, size, ip, &step)) < 0 || (ip = readVarint(src, size, ip, &count)) < 0 ||
+            count >= pairs)
+            return -1;
+        source += unzigzag(step);
+        pairs -= count + 1;
+        do {
+            if ((ip = readVarint(src, size, ip, &step)) < 0)
+                return -1;
+            destination = absolute ? (long long)step : destination + unzigzag(step);
+            if (source < 0 || source > INT_MAX || destination < 0 || destination > INT_MAX)
+                return -1;
+            int length = sprintf(line, "%lld -> %lld\n", source, destination);
+            if (length > dst + capacity - op)
+                return -1;
+            memcpy(op, line, length);
+            op += length;
+        } while (count-- > 0);
+    }
+
+    if (size - ip > dst + capacity - op)
+        return -1;
+    memcpy(op, src + ip, size - ip);
+    op += size - ip;
+    return (int)(op - dst);
+}
+
+// Function to find the Huffman code lengths of the byte values, none longer than CLZ_CODE_BITS
+void huffmanLengths(const long *count, unsigned char *length) {
+    long weight[512];
+    int parent[512], alive[512], nodes, used = 0, symbol, shift;
+
+    for (shift = 0; ; shift++) {
+        // The counts are halved until the deepest code is short enough
+        nodes = 256;
+        used = 0;
+        for (symbol = 0; symbol < 256; symbol++) {
+            weight[symbol] = count[symbol] > 0 ? ((count[symbol] - 1) >> shift) + 1 : 0;
+            alive[symbol] = count[symbol] > 0;
+            parent[symbol] = -1;
+            used += alive[symbol];
+        }
+        memset(length, 0, 256);
+        if (used == 1) {
+            for (symbol = 0; symbol < 256; symbol++)
+                length[symbol] = alive[symbol];
+            return;
+        }
+
+        // Join the two lightest trees until one is left
+        while (used > 1) {
+            int first = -1, second = -1, k;
+            for (k = 0; k < nodes; k++) {
+                if (!alive[k])
+                    continue;
+                if (first < 0 || weight[k] < weight[first]) {
+                    second = first;
+                    first = k;
+                }
+                else if (second < 0 || weight[k] < weight[second]) {
+                    second = k;
+                }
+            }
+            weight[nodes] = weight[first] + weight[second];
+            alive[nodes] = 1;
+            parent[nodes] = -1;
+            alive[first] = alive[second] = 0;
+            parent[first] = parent[second] = nodes;
+            nodes++;
+            used--;
+        }
+
+        int deepest = 0;
+        for (symbol = 0; symbol < 256; symbol++) {
+            int depth = 0, node;
+            if (count[symbol] == 0)
+                continue;
+            for (node = symbol; parent[node] >= 0; node = parent[node])
+                depth++;
+            length[symbol] = (unsigned char)depth;
+            deepest = depth > deepest ? depth : deepest;
+        }
+        if (deepest <= CLZ_CODE_BITS)
+            return;
+    }
+}
+
+// Function to assign the canonical codes of the code lengths: shorter codes first, then by byte value
+void huffmanCodes(const unsigned char *length, unsigned int *code) {
+    int perLength[CLZ_CODE_BITS + 1] = {0}, bits, symbol;
+    unsigned int next[CLZ_CODE_BITS + 2], value = 0;
+
+    for (symbol = 0; symbol < 256; symbol++)
+        perLength[length[symbol]]++;
+    perLength[0] = 0;
+    for (bits = 1; bits <= CLZ_CODE_BITS; bits++) {
+        value = (value + perLength[bits - 1]) << 1;
+        next[bits] = value;
+    }
+    for (symbol = 0; symbol < 256; symbol++) {
+        if (length[symbol] > 0)
+            code[symbol] = next[length[symbol]]++;
+    }
+}
+
+int huffmanEncode(const unsigned char *src, int size, unsigned char *dst, int capacity) {
+    long count[2][256] = {{0}};
+    unsigned char length[2][256];
+    unsigned int code[2][256];
+    unsigned long long bitBuffer = 0;
+    int bitCount = 0, i, op, context = 0;
+
+    if (capacity < 4 + 256 + 8)
+        return -1;
+    for (i = 0; i < size; i++) {
+        count[context][src[i]]++;
+        context = src[i] >> 7;
+    }
+    for (context = 0; context < 2; context++) {
+        huffmanLengths(count[context], length[context]);
+        huffmanCodes(length[context], code[context]);
+        for (i = 0; i < 128; i++)
+            dst[4 + 128 * context + i] = (unsigned char)(length[context][2 * i] | (length[context][2 * i + 1] << 4));
+    }
+    writeLE32(dst, (unsigned long)size);
+    op = 4 + 256;
+
+    // The bits of a code go out from its first bit, each into the lowest free bit of the output
+    for (i = 0, context = 0; i < size; context = src[i++] >> 7) {
+        int bits = length[context][src[i]], k;
+        for (k = bits - 1; k >= 0; k--)
+            bitBuffer |= (unsigned long long)((code[context][src[i]] >> k) & 1) << bitCount++;
+        while (bitCount >= 8) {
+            if (op >= capacity)
+                return -1;
+            dst[op++] = (unsigned char)bitBuffer;
+            bitBuffer >>= 8;
+            bitCount -= 8;
+        }
+    }
+    if (bitCount > 0) {
+        if (op >= capacity)
+            return -1;
+        dst[op++] = (unsigned char)bitBuffer;
+    }
+    return op;
+}
+
+int huffmanDecode(const unsigned char *src, int size, unsigned char *dst, int capacity) {
+    int perLength[2][CLZ_CODE_BITS + 1] = {{0}}, offset[2][CLZ_CODE_BITS + 2], position[CLZ_CODE_BITS + 2];
+    unsigned char sorted[2][256];
+    int i, bits, symbol, context;
+
+    if (size < 4 + 256)
+        return -1;
+    unsigned long count = readLE32(src);
+    if (count > (unsigned long)capacity)
+        return -1;
+
+    // The byte values of each context in the order of their canonical codes
+    for (context = 0; context < 2; context++) {
+        const unsigned char *lengths = src + 4 + 128 * context;
+        for (symbol = 0; symbol < 256; symbol++)
+            perLength[context][(lengths[symbol / 2] >> (4 * (symbol % 2))) & 15]++;
+        perLength[context][0] = 0;
+        offset[context][1] = 0;
+        for (bits = 1; bits <= CLZ_CODE_BITS; bits++)
+            offset[context][bits + 1] = offset[context][bits] + perLength[context][bits];
+        memcpy(position, offset[context], sizeof(position));
+        for (symbol = 0; symbol < 256; symbol++) {
+            int length = (lengths[symbol / 2] >> (4 * (symbol % 2))) & 15;
+            if (length > 0)
+                sorted[context][position[length]++] = (unsigned char)symbol;
+        }
+    }
+
+    // A code is read bit after bit until it falls in the range of the codes of its length
+    long bitPosition = (4 + 256) * 8L, bitEnd = (long)size * 8;
+    for (i = 0, context = 0; i < (long)count; context = dst[i++] >> 7) {
+        int value = 0, first = 0;
+        for (bits = 1; ; bits++) {
+            if (bits > CLZ_CODE_BITS || bitPosition >= bitEnd)
+                return -1;
+            value |= (src[bitPosition >> 3] >> (bitPosition & 7)) & 1;
+            bitPosition++;
+            if (value - first < perLength[context][bits]) {
+                dst[i] = sorted[context][offset[context][bits] + value - first];
+                break;
+            }
+            first = (first + perLength[context][bits]) << 1;
+            value <<= 1;
+        }
+    }
+    return (int)count;
+}
+
+void clzCompress(FILE *in, FILE *out) {
+    unsigned char *raw = (unsigned char *)malloc(CLZ_BLOCK);
+    unsigned char *pairs = (unsigned char *)malloc(CLZ_BLOCK);
+    unsigned char *packed = (unsigned char *)malloc(CLZ_BOUND(CLZ_BLOCK));
+    unsigned char *coded = (unsigned char *)malloc(CLZ_BLOCK);
+    unsigned char *literal = (unsigned char *)malloc(CLZ_BLOCK);
+    unsigned char header[8];
+    size_t size;
+
+    if (raw == NULL || pairs == NULL || packed == NULL || coded == NULL || literal == NULL) {
+        fprintf(stderr, "Error: Not enough memory for the compressor.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    fwrite(CLZ_MAGIC, 1, 4, out);
+    while ((size = fread(raw, 1, CLZ_BLOCK, in)) > 0) {
+        const unsigned char *block = raw;
+        int blockSize = (int)size, flags = 0;
+
+        int pairSize = pairEncode(raw, (int)size, pairs, CLZ_BLOCK);
+        if (pairSize > 0) {
+            block = pairs;
+            blockSize = pairSize;
+            flags = CLZ_PAIRS;
+        }
+
+        // Keep the smallest of the block, its LZ sequences and the Huffman codes of either
+        const unsigned char *best = block;
+        int bestSize = blockSize, bestFlags = flags;
+        int packedSize = clzCompressBlock(block, blockSize, packed);
+        if (packedSize < bestSize) {
+            best = packed;
+            bestSize = packedSize;
+            bestFlags = flags | CLZ_LZ;
+        }
+        int codedSize = huffmanEncode(packed, packedSize, coded, bestSize - 1);
+        if (codedSize > 0) {
+            best = coded;
+            bestSize = codedSize;
+            bestFlags = flags | CLZ_LZ | CLZ_HUFFMAN;
+        }
+        int literalSize = huffmanEncode(block, blockSize, literal, bestSize - 1);
+        if (literalSize > 0) {
+            best = literal;
+            bestSize = literalSize;
+            bestFlags = flags | CLZ_HUFFMAN;
+        }
+        int stored = bestSize + 1 < (int)size;
+
+        writeLE32(header, size);
+        writeLE32(header + 4, stored ? bestSize + 1 : (int)size);
+        fwrite(header, 1, 8, out);
+        if (stored) {
+            fputc(bestFlags, out);
+            fwrite(best, 1, bestSize, out);
+        }
+        else {
+            fwrite(raw, 1, size, out);
+        }
+    }
+
+    writeLE32(header, 0);
+    fwrite(header, 1, 4, out);
+
+    free(raw);
+    free(pairs);
+    free(packed);
+    free(coded);
+    free(literal);
+}
+
+int clzVersion(const char *magic) {
+    if (memcmp(magic, CLZ_MAGIC, 4) == 0)
+        return 2;
+    return memcmp(magic, CLZ_MAGIC_LZ, 4) == 0 ? 1 : 0;
+}
+
+int clzDecompress(FILE *in, FILE *out, int version) {
+    unsigned char *raw = (unsigned char *)malloc(CLZ_BLOCK);
+    unsigned char *packed = (unsigned char *)malloc(CLZ_BLOCK);
+    unsigned char *sequences = (unsigned char *)malloc(CLZ_BOUND(CLZ_BLOCK));
+    unsigned char *pairs = (unsigned char *)malloc(CLZ_BLOCK);
+    unsigned char header[8];
+    int status = -1;
+
+    if (raw == NULL || packed == NULL || sequences == NULL || pairs == NULL) {
+        fprintf(stderr, "Error: Not enough memory for the decompressor.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    while (fread(header, 1, 4, in) == 4) {
+        unsigned long size = readLE32(header);
+        if (size == 0) {
+            status = 0;
+            break;
+        }
+
+        if (fread(header + 4, 1, 4, in) != 4)
+            break;
+        unsigned long storedSize = readLE32(header + 4);
+        if (size > CLZ_BLOCK || storedSize > size)
+            break;
+
+        if (storedSize == size) {
+            // The block was kept raw
+            if (fread(raw, 1, size, in) != size)
+                break;
+        }
+        else if (version == 1) {
+            if (fread(packed, 1, storedSize, in) != storedSize)
+                break;
+            if (clzDecompressBlock(packed, (int)storedSize, raw, CLZ_BLOCK) != (int)size)
+                break;
+        }
+        else {
+            // The stages of clzCompress in reverse
+            if (storedSize == 0 || fread(packed, 1, storedSize, in) != storedSize)
+                break;
+            int flags = packed[0];
+            const unsigned char *data = packed + 1;
+            int dataSize = (int)storedSize - 1;
+            if (flags & ~(CLZ_PAIRS | CLZ_LZ | CLZ_HUFFMAN))
+                break;
+            if (flags & CLZ_HUFFMAN) {
+                dataSize = huffmanDecode(data, dataSize, sequences, CLZ_BOUND(CLZ_BLOCK));
+                data = sequences;
+                if (dataSize < 0)
+                    break;
+            }
+            if (flags & CLZ_LZ) {
+                unsigned char *block = flags & CLZ_PAIRS ? pairs : raw;
+                dataSize = clzDecompressBlock(data, dataSize, block, CLZ_BLOCK);
+                data = block;
+                if (dataSize < 0)
+                    break;
+            }
+            if (flags & CLZ_PAIRS)
+                dataSize = pairDecode(data, dataSize, raw, CLZ_BLOCK);
+            else if (data != raw && dataSize == (int)size)
+                memcpy(raw, data, size);
+            if (dataSize != (int)size)
+                break;
+        }
+
+        if (fwrite(raw, 1, size, out) != size)
+            break;
+    }
+
+    free(raw);
+    free(packed);
+    free(sequences);
+    free(pairs);
+    return status;
+}
+
+// Thread body that decompresses an input file into the pipe read by the parser
+void *decompressInputThread(void *arg) {
+    Input *input = (Input *)arg;
+
+    // A failure shows up to the parser as a file ending too early
+    if (clzDecompress(input->file, input->pipe, input->version) != 0)
+        fprintf(stderr, "Warning: The compressed input file stopped early or is corrupt.\n");
+
+    // Closing the write end lets the parser see the end of the text
+    fclose(input->pipe);
+    return NULL;
+}
+
+Input *openInput(const char *filename) {
+    Input *input = (Input *)malloc(sizeof(Input));
+    char magic[4];
+
+    if (filename == NULL) {
+        fprintf(stderr, "No input file given! The -i option must come first.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    input->file = fopen(filename, "rb");
+    if (input->file == NULL) {
+        fprintf(stderr, "Error: Unable to open the input file for reading.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    if (fread(magic, 1, 4, input->file) != 4 || (input->version = clzVersion(magic)) == 0) {
+        // A plain text file is parsed directly
+        rewind(input->file);
+        input->stream = input->file;
+        input->pipe = NULL;
+        return input;
+    }
+
+    int fds[2];
+    if (pipe(fds) != 0) {
+        fprintf(stderr, "Error: Unable to create the decompression pipe.\n");
+        exit(EXIT_FAILURE);
+    }
+    input->stream = fdopen(fds[0], "r");
+    input->pipe = fdopen(fds[1], "w");
+
+    // The parser may stop reading before the end of the text, which must not kill the program
+    signal(SIGPIPE, SIG_IGN);
+
+    if (pthread_create(&input->thread, NULL, decompressInputThread, input) != 0) {
+        fprintf(stderr, "Error: Unable to start the decompression thread.\n");
+        exit(EXIT_FAILURE);
+    }
+    return input;
+}
+
+void closeInput(Input *input) {
+    if (input->pipe != NULL) {
+        // Closing the read end stops a decompressor still writing text nobody reads
+        fclose(input->stream);
+        pthread_join(input->thread, NULL);
+    }
+    fclose(input->file);
+    free(input);
+}
+
+void implementPack(const char *path) {
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) {
+        fprintf(stderr, "Error: Unable to open %s for reading.\n", path);
+        exit(EXIT_FAILURE);
+    }
+
+    char *packed = (char *)malloc(strlen(path) + 5); // 5 = length of ".clz" plus null terminator
+    strcpy(packed, path);
+    strcat(packed, ".clz");
+
+    FILE *out = fopen(packed, "wb");
+    if (out == NULL) {
+        fprintf(stderr, "Error opening the output file \n");
+        exit(EXIT_FAILURE);
+    }
+
+    clzCompress(file, out);
+    fclose(file);
+    if (fclose(out) != 0) {
+        fprintf(stderr, "Error: Unable to write %s.\n", packed);
+        exit(EXIT_FAILURE);
+    }
+    printf("Saving %s...\n", packed);
+    free(packed);
+}
+
+void implementUnpack(const char *path) {
+    char magic[4];
+
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) {
+        fprintf(stderr, "Error: Unable to open the compressed file for reading.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    int version = fread(magic, 1, 4, file) == 4 ? clzVersion(magic) : 0;
+    if (version == 0) {
+        fprintf(stderr, "Error: %s is not a CLZ compressed file.\n", path);
+        exit(EXIT_FAILURE);
+    }
+
+    if (clzDecompress(file, stdout, version) != 0) {
+        fprintf(stderr, "Error: The compressed file %s is corrupt.\n", path);
+        exit(EXIT_FAILURE);
+    }
+    fclose(file);
+}
+
+// Function to make room for more bytes at the start of a FlatBuffers message
+void fbGrow(FlatBuilder *fb, size_t needed) {
+    if (fb->size + needed <= fb->capacity)
+        return;
+
+    size_t capacity = fb->capacity ? fb->capacity : 256;
+    while (fb->size + needed > capacity)
+        capacity *= 2;
+
+    // The bytes built so far stay at the end of the larger buffer
+    unsigned char *data = (unsigned char *)malloc(capacity);
+    if (fb->size > 0)
+        memcpy(data + capacity - fb->size, fb->data + fb->capacity - fb->size, fb->size);
+    free(fb->data);
+    fb->data = data;
+    fb->capacity = capacity;
+}
+
+// Function to add little endian bytes at the start of a FlatBuffers message, without alignment
+void fbPut(FlatBuilder *fb, uint64_t value, int bytes) {
+    int k;
+    fbGrow(fb, bytes);
+    fb->size += bytes;
+    for (k = 0; k < bytes; k++)
+        fb->data[fb->capacity - fb->size + k] = (value >> (8 * k)) & 0xff;
+}
+
+void fbPrep(FlatBuilder *fb, size_t align, size_t additional) {
+    if (align > fb->minAlign)
+        fb->minAlign = align;
+
+    size_t pad = (align - (fb->size + additional) % align) % align;
+    while (pad-- > 0)
+        fbPut(fb, 0, 1);
+}
+
+void fbScalar(FlatBuilder *fb, uint64_t value, int bytes) {
+    fbPrep(fb, bytes, 0);
+    fbPut(fb, value, bytes);
+}
+
+size_t fbOffset(FlatBuilder *fb, size_t target) {
+    fbPrep(fb, 4, 0);
+    // Offsets point forward, from the offset itself to the object
+    fbPut(fb, fb->size + 4 - target, 4);
+    return fb->size;
+}
+
+void fbStartTable(FlatBuilder *fb, int fieldCount) {
+    memset(fb->fields, 0, sizeof(fb->fields));
+    fb->fieldCount = fieldCount;
+    fb->tableStart = fb->size;
+}
+
+void fbFieldScalar(FlatBuilder *fb, int slot, uint64_t value, int bytes) {
+    fbScalar(fb, value, bytes);
+    fb->fields[slot] = fb->size;
+}
+
+void fbFieldOffset(FlatBuilder *fb, int slot, size_t target) {
+    fb->fields[slot] = fbOffset(fb, target);
+}
+
+size_t fbEndTable(FlatBuilder *fb) {
+    int slot;
+
+    // The table starts with the offset back to its vtable, filled in below
+    fbScalar(fb, 0, 4);
+    size_t table = fb->size;
+
+    // The vtable holds its own size, the size of the table and where each field is in the table
+    for (slot = fb->fieldCount - 1; slot >= 0; slot--)
+        fbPut(fb, fb->fields[slot] ? table - fb->fields[slot] : 0, 2);
+    fbPut(fb, table - fb->tableStart, 2);
+    fbPut(fb, (2 + fb->fieldCount) * 2, 2);
+
+    writeLE32(fb->data + fb->capacity - table, fb->size - table);
+    return table;
+}
+
+size_t fbString(FlatBuilder *fb, const char *text) {
+    size_t length = strlen(text);
+
+    fbPrep(fb, 4, length + 1);
+    fbPut(fb, 0, 1);
+    fbGrow(fb, length);
+    fb->size += length;
+    memcpy(fb->data + fb->capacity - fb->size, text, length);
+    fbPut(fb, length, 4);
+    return fb->size;
+}
+
+void fbStartVector(FlatBuilder *fb, size_t elementSize, size_t count, size_t align) {
+    fbPrep(fb, 4, elementSize * count);
+    fbPrep(fb, align, elementSize * count);
+}
+
+size_t fbEndVector(FlatBuilder *fb, size_t count) {
+    fbPut(fb, count, 4);
+    return fb->size;
+}
+
+// Function to write a FlatBuffers Message and its body as an encapsulated Arrow IPC message
+void writeArrowMessage(FILE *out, FlatBuilder *fb, size_t header, int headerType, const unsigned char *body, size_t bodyLength) {
+    unsigned char prefix[8];
+    static const unsigned char zeros[8] = {0};
+
+    // Message: version, header_type, header, bodyLength
+    fbStartTable(fb, 5);
+    fbFieldScalar(fb, 3, bodyLength, 8);
+    fbFieldOffset(fb, 2, header);
+    fbFieldScalar(fb, 0, 4, 2); // MetadataVersion V5
+    fbFieldScalar(fb, 1, headerType, 1);
+    size_t message = fbEndTable(fb);
+
+    fbPrep(fb, fb->minAlign > 8 ? fb->minAlign : 8, 4);
+    fbOffset(fb, message);
+
+    // The metadata is padded so that the body starts at a multiple of 8 bytes
+    size_t padded = (fb->size + 7) / 8 * 8;
+    writeLE32(prefix, 0xffffffffUL);
+    writeLE32(prefix + 4, padded);
+    fwrite(prefix, 1, 8, out);
+    fwrite(fb->data + fb->capacity - fb->size, 1, fb->size, out);
+    fwrite(zeros, 1, padded - fb->size, out);
+    if (bodyLength > 0)
+        fwrite(body, 1, bodyLength, out);
+
+    free(fb->data);
+    memset(fb, 0, sizeof(*fb));
+}
+
+ArrowWriter *createArrowWriter(FILE *out, int withHops) {
+    static const char *names[] = {"source", "destination", "hops"};
+    ArrowWriter *writer = (ArrowWriter *)malloc(sizeof(ArrowWriter));
+    FlatBuilder fb;
+    size_t field[3];
+    int c;
+
+    writer->out = out;
+    writer->withHops = withHops;
+    writer->columns = withHops ? 3 : 2;
+    writer->rows = 0;
+    for (c = 0; c < writer->columns; c++)
+        writer->column[c] = (unsigned char *)malloc(4 * ARROW_BATCH);
+
+    memset(&fb, 0, sizeof(fb));
+    for (c = 0; c < writer->columns; c++) {
+        size_t name = fbString(&fb, names[c]);
+
+        // Int: bitWidth, is_signed
+        fbStartTable(&fb, 2);
+        fbFieldScalar(&fb, 0, 32, 4);
+        fbFieldScalar(&fb, 1, 1, 1);
+        size_t type = fbEndTable(&fb);
+
+        fbStartVector(&fb, 4, 0, 4);
+        size_t children = fbEndVector(&fb, 0);
+
+        // Field: name, nullable, type_type, type, dictionary, children
+        fbStartTable(&fb, 6);
+        fbFieldOffset(&fb, 0, name);
+        fbFieldOffset(&fb, 3, type);
+        fbFieldOffset(&fb, 5, children);
+        fbFieldScalar(&fb, 1, 0, 1);
+        fbFieldScalar(&fb, 2, 2, 1); // Type Int
+        field[c] = fbEndTable(&fb);
+    }
+
+    fbStartVector(&fb, 4, writer->columns, 4);
+    for (c = writer->columns - 1; c >= 0; c--)
+        fbOffset(&fb, field[c]);
+    size_t fields = fbEndVector(&fb, writer->columns);
+
+    // Schema: endianness, fields
+    fbStartTable(&fb, 4);
+    fbFieldOffset(&fb, 1, fields);
+    fbFieldScalar(&fb, 0, 0, 2); // Little endian
+    size_t schema = fbEndTable(&fb);
+
+    writeArrowMessage(out, &fb, schema, 1, NULL, 0); // MessageHeader Schema
+    return writer;
+}
+
+// Function to write the pairs gathered so far as one record batch
+void flushArrowBatch(ArrowWriter *writer) {
+    size_t columnLength = 4 * (size_t)writer->rows;
+    size_t paddedLength = (columnLength + 7) / 8 * 8;
+    FlatBuilder fb;
+    int c;
+
+    if (writer->rows == 0)
+        return;
+
+    memset(&fb, 0, sizeof(fb));
+
+    // FieldNode structs: length, null_count
+    fbStartVector(&fb, 16, writer->columns, 8);
+    for (c = writer->columns - 1; c >= 0; c--) {
+        fbPut(&fb, 0, 8);
+        fbPut(&fb, writer->rows, 8);
+    }
+    size_t nodes = fbEndVector(&fb, writer->columns);
+
+    // Buffer structs: offset, length; each column has an empty validity buffer and its values
+    fbStartVector(&fb, 16, 2 * writer->columns, 8);
+    for (c = writer->columns - 1; c >= 0; c--) {
+        fbPut(&fb, columnLength, 8);
+        fbPut(&fb, c * paddedLength, 8);
+        fbPut(&fb, 0, 8);
+        fbPut(&fb, c * paddedLength, 8);
+    }
+    size_t buffers = fbEndVector(&fb, 2 * writer->columns);
+
+    // RecordBatch: length, nodes, buffers
+    fbStartTable(&fb, 3);
+    fbFieldScalar(&fb, 0, writer->rows, 8);
+    fbFieldOffset(&fb, 1, nodes);
+    fbFieldOffset(&fb, 2, buffers);
+    size_t batch = fbEndTable(&fb);
+
+    // The body holds the columns one after the other, each padded to 8 bytes
+    unsigned char *body = (unsigned char *)calloc(writer->columns, paddedLength);
+    for (c = 0; c < writer->columns; c++)
+        memcpy(body + c * paddedLength, writer->column[c], columnLength);
+
+    writeArrowMessage(writer->out, &fb, batch, 3, body, writer->columns * paddedLength); // MessageHeader RecordBatch
+    free(body);
+    writer->rows = 0;
+}
+
+void writeArrowPair(void *context, int source, int destination, int round) {
+    ArrowWriter *writer = (ArrowWriter *)context;
+
+    writeLE32(writer->column[0] + 4 * writer->rows, source);
+    writeLE32(writer->column[1] + 4 * writer->rows, destination);
+    if (writer->withHops)
+        writeLE32(writer->column[2] + 4 * writer->rows, round + 1);
+
+    if (++writer->rows == ARROW_BATCH)
+        flushArrowBatch(writer);
+}
+
+void finishArrowWriter(ArrowWriter *writer) {
+    unsigned char end[8];
+    int c;
+
+    flushArrowBatch(writer);
+
+    // The end of the stream is a continuation marker followed by an empty message
+    writeLE32(end, 0xffffffffUL);
+    writeLE32(end + 4, 0);
+    fwrite(end, 1, 8, writer->out);
+
+    for (c = 0; c < writer->columns; c++)
+        free(writer->column[c]);
+    free(writer);
+}
+
+char byteText[256][16]; // The text "b b b b b b b b " of the 8 cells of each byte
+pthread_once_t byteTextOnce = PTHREAD_ONCE_INIT;
+
+// Function to fill the byte-to-text table
+void initByteText(void) {
+    int value, k;
+    for (value = 0; value < 256; value++) {
+        for (k = 0; k < 8; k++) {
+            byteText[value][2 * k] = (value >> (7 - k)) & 1 ? '1' : '0';
+            byteText[value][2 * k + 1] = ' ';
+        }
+    }
+}
+
+int packRow(const int *row, unsigned char *bits) {
+    int j;
+
+    memset(bits, 0, ((size_t)N + 7) / 8);
+    for (j = 0; j < N; j++) {
+        if (row[j] != 0 && row[j] != 1)
+            return -1;
+        bits[j / 8] |= row[j] << (7 - j % 8);
+    }
+    return 0;
+}
+
+void writeBitRow(FILE *out, const unsigned char *bits, char *text, int trailingSpace) {
+    int b;
+
+    pthread_once(&byteTextOnce, initByteText);
+
+    // Every byte gives the text of 8 cells; the cells past N in the last byte are cut off
+    for (b = 0; b < (N + 7) / 8; b++)
+        memcpy(text + 16 * b, byteText[bits[b]], N - 8 * b >= 8 ? 16 : 2 * (N - 8 * b));
+
+    size_t length = 2 * (size_t)N;
+    if (!trailingSpace && length > 0)
+        length--;
+    text[length++] = '\n';
+    fwrite(text, 1, length, out);
+}
+
+void setPairBit(void *context, int source, int destination, int round) {
+    BitRows *rows = (BitRows *)context;
+    (void)round;
+    rows->bits[(size_t)(source - rows->first) * rows->rowBytes + destination / 8] |= 1 << (7 - destination % 8);
+}
+
+long writeClosureMatrix(FILE *out, int first, int last) {
+    BitRows rows;
+    int u;
+
+    rows.rowBytes = ((size_t)N + 7) / 8;
+    rows.first = first;
+    rows.bits = (unsigned char *)calloc((size_t)(last - first) * rows.rowBytes + 1, 1);
+
+    long pairs = closeRange(cityMatrix, first, last, setPairBit, &rows);
+
+    char *text = (char *)malloc(2 * (size_t)N + 1);
+    for (u = first; u < last; u++)
+        writeBitRow(out, rows.bits + (size_t)(u - first) * rows.rowBytes, text, 0);
+
+    free(text);
+    free(rows.bits);
+    return pairs;
+}
+
+void loadGraph(const char *filename) {
+    // The network stays loaded until another input file is read
+    if (loadedFile != NULL && filename != NULL && strcmp(loadedFile, filename) == 0)
+        return;
+
+    Input *input = openInput(filename);
+    readAdjacencyMatrix(input->stream);
+    closeInput(input);
+
+    free(loadedFile);
+    loadedFile = (char *)malloc(strlen(filename) + 1);
+    strcpy(loadedFile, filename);
+
+    if (statsOutput)
+        printGraphStats();
+}
+
+void freeGraph(void) {
+    if (cityMatrix != NULL)
+        freeMatrix(cityMatrix, N);
+    cityMatrix = NULL;
+
+    free(rowStart);
+    free(adjacency);
+    free(weight);
+    free(adjacencyBits);
+    free(survival);
+    free(incomingStart);
+    free(incoming);
+    rowStart = NULL;
+    adjacency = NULL;
+    weight = NULL;
+    adjacencyBits = NULL;
+    incomingStart = NULL;
+    incoming = NULL;
+    survival = NULL;
+    edgeCount = 0;
+
+    // The chains are built on demand by planClosure
+    free(cityComponent);
+    free(componentStart);
+    free(componentCities);
+    free(componentCycle);
+    free(chainStart);
+    free(chainComponents);
+    free(chainOf);
+    free(chainPosition);
+    free(chainLabels);
+    cityComponent = componentStart = componentCities = NULL;
+    componentCycle = NULL;
+    chainStart = chainComponents = chainOf = chainPosition = chainLabels = NULL;
+    free(routeTable);
+    routeTable = NULL;
+
+    free(loadedFile);
+    loadedFile = NULL;
+
+    // The coordinates belong to the cities of the network
+    free(latitude);
+    free(longitude);
+    free(planeX);
+    free(planeY);
+    free(cellStart);
+    free(cellCities);
+    latitude = longitude = planeX = planeY = NULL;
+    cellStart = cellCities = NULL;
+}
+
+// Function to read a non-negative number; returns 1 on success, 0 at the end of the file and -1 on other text
+int readNumber(FILE *inputFile, long *value) {
+    int c;
+
+    do {
+        c = getc_unlocked(inputFile);
+    } while (c == ' ' || c == '\t' || c == '\n' || c == '\r');
+
+    if (c == EOF)
+        return 0;
+    if (!isdigit(c))
+        return -1;
+
+    *value = 0;
+    while (isdigit(c)) {
+        *value = *value * 10 + (c - '0');
+        if (*value > INT_MAX)
+            return -1;
+        c = getc_unlocked(inputFile);
+    }
+    if (c != EOF)
+        ungetc(c, inputFile);
+    return 1;
+}
+
+void readEdgeList(FILE *inputFile, int weighted) {
+    long capacity = 1024, count = 0;
+    int *from = (int *)malloc(capacity * sizeof(int));
+    int *to = (int *)malloc(capacity * sizeof(int));
+    int *cost = weighted ? (int *)malloc(capacity * sizeof(int)) : NULL;
+    long source, destination, value = 1;
+    int status;
+
+    while ((status = readNumber(inputFile, &source)) == 1) {
+        if (readNumber(inputFile, &destination) != 1 || source >= N || destination >= N ||
+            (weighted && readNumber(inputFile, &value) != 1)) {
+            status = -1;
+            break;
+        }
+
+        if (count == capacity) {
+            capacity *= 2;
+            checkMemory((size_t)capacity * (weighted ? 3 : 2) * sizeof(int) + ((size_t)N + 1) * sizeof(long), "Reading the connections");
+            from = (int *)realloc(from, capacity * sizeof(int));
+            to = (int *)realloc(to, capacity * sizeof(int));
+            if (weighted)
+                cost = (int *)realloc(cost, capacity * sizeof(int));
+            if (from == NULL || to == NULL || (weighted && cost == NULL)) {
+                fprintf(stderr, "Error: Not enough memory for %ld connections.\n", capacity);
+                exit(EXIT_FAILURE);
+            }
+        }
+        from[count] = (int)source;
+        to[count] = (int)destination;
+        if (weighted)
+            cost[count] = (int)value;
+        count++;
+    }
+
+    if (status != 0) {
+        fprintf(stderr, "Error: Failed to read the connections from the input file.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    buildGraph(from, to, cost, count);
+    free(from);
+    free(to);
+    free(cost);
+}
+
+// Function to compare two connections packed as (city << 32 | cost) for qsort
+int compareLinks(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+// Function to build the adjacency lists with the costs, keeping the cheapest of repeated connections
+void buildWeightedGraph(const int *from, const int *to, const int *cost, long count) {
+    long e;
+    int u;
+
+    rowStart = (long *)calloc((size_t)N + 1, sizeof(long));
+    uint64_t *links = (uint64_t *)malloc((count > 0 ? count : 1) * sizeof(uint64_t));
+    if (rowStart == NULL || links == NULL) {
+        fprintf(stderr, "Error: Not enough memory for %ld connections.\n", count);
+        exit(EXIT_FAILURE);
+    }
+
+    for (e = 0; e < count; e++)
+        rowStart[from[e] + 1]++;
+    for (u = 0; u < N; u++)
+        rowStart[u + 1] += rowStart[u];
+
+    long *position = (long *)malloc(((size_t)N + 1) * sizeof(long));
+    memcpy(position, rowStart, ((size_t)N + 1) * sizeof(long));
+    for (e = 0; e < count; e++)
+        links[position[from[e]]++] = (uint64_t)to[e] << 32 | (uint32_t)cost[e];
+    free(position);
+
+    // Sorted by city and then cost, the first of repeated connections is the cheapest
+    long kept = 0;
+    for (u = 0; u < N; u++) {
+        long start = rowStart[u], end = rowStart[u + 1];
+        qsort(links + start, end - start, sizeof(uint64_t), compareLinks);
+
+        rowStart[u] = kept;
+        for (e = start; e < end; e++) {
+            if (e == start || links[e] >> 32 != links[e - 1] >> 32)
+                links[kept++] = links[e];
+        }
+    }
+    rowStart[N] = kept;
+    edgeCount = kept;
+
+    adjacency = (int *)malloc((kept > 0 ? kept : 1) * sizeof(int));
+    weight = (int *)malloc((kept > 0 ? kept : 1) * sizeof(int));
+    for (e = 0; e < kept; e++) {
+        adjacency[e] = (int)(links[e] >> 32);
+        weight[e] = (int)(uint32_t)links[e];
+    }
+    free(links);
+}
+
+void buildReverse(long **reverseStart, int **reverseAdjacency, int **reverseWeight) {
+    long *start = (long *)calloc((size_t)N + 1, sizeof(long));
+    int *list = (int *)malloc((edgeCount > 0 ? edgeCount : 1) * sizeof(int));
+    int *costs = weight != NULL ? (int *)malloc((edgeCount > 0 ? edgeCount : 1) * sizeof(int)) : NULL;
+    long e;
+    int u;
+
+    if (start == NULL || list == NULL || (weight != NULL && costs == NULL)) {
+        fprintf(stderr, "Error: Not enough memory for the reversed network.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    for (e = 0; e < edgeCount; e++)
+        start[adjacency[e] + 1]++;
+    for (u = 0; u < N; u++)
+        start[u + 1] += start[u];
+
+    // Going through the sources in ascending order keeps every reversed row sorted
+    long *position = (long *)malloc(((size_t)N + 1) * sizeof(long));
+    memcpy(position, start, ((size_t)N + 1) * sizeof(long));
+    for (u = 0; u < N; u++) {
+        for (e = rowStart[u]; e < rowStart[u + 1]; e++) {
+            long p = position[adjacency[e]]++;
+            list[p] = u;
+            if (costs != NULL)
+                costs[p] = weight[e];
+        }
+    }
+    free(position);
+
+    *reverseStart = start;
+    *reverseAdjacency = list;
+    *reverseWeight = costs;
+}
+
+int linkCost(const int *costs, long e) {
+    return costs != NULL && !hopsOnly ? costs[e] : 1;
+}
+
+// Function to compare two cities for qsort
+int compareCities(const void *a, const void *b) {
+    int x = *(const int *)a, y = *(const int *)b;
+    return (x > y) - (x < y);
+}
+
+void buildGraph(const int *from, const int *to, const int *cost, long count) {
+    long e;
+    int u;
+
+    if (cost != NULL) {
+        buildWeightedGraph(from, to, cost, count);
+        return;
+    }
+
+    rowStart = (long *)calloc((size_t)N + 1, sizeof(long));
+    adjacency = (int *)malloc((count > 0 ? count : 1) * sizeof(int));
+    if (rowStart == NULL || adjacency == NULL) {
+        fprintf(stderr, "Error: Not enough memory for %ld connections.\n", count);
+        exit(EXIT_FAILURE);
+    }
+
+    // Count the connections of each city, then place them with a running position per city
+    for (e = 0; e < count; e++)
+        rowStart[from[e] + 1]++;
+    for (u = 0; u < N; u++)
+        rowStart[u + 1] += rowStart[u];
+
+    long *position = (long *)malloc(((size_t)N + 1) * sizeof(long));
+    memcpy(position, rowStart, ((size_t)N + 1) * sizeof(long));
+    for (e = 0; e < count; e++)
+        adjacency[position[from[e]]++] = to[e];
+    free(position);
+
+    // Sort the neighbors of each city and drop the repeated ones
+    long kept = 0;
+    for (u = 0; u < N; u++) {
+        long start = rowStart[u], end = rowStart[u + 1];
+        qsort(adjacency + start, end - start, sizeof(int), compareCities);
+
+        rowStart[u] = kept;
+        for (e = start; e < end; e++) {
+            if (e == start || adjacency[e] != adjacency[e - 1])
+                adjacency[kept++] = adjacency[e];
+        }
+    }
+    rowStart[N] = kept;
+    edgeCount = kept;
+}
+
+void appendRow(int city, const int *row, long *capacity) {
+    int j;
+
+    for (j = 0; j < N; j++) {
+        if (row[j] == 0)
+            continue;
+
+        if (edgeCount == *capacity) {
+            *capacity *= 2;
+            checkMemory((size_t)*capacity * sizeof(int) * (weight != NULL ? 2 : 1) + ((size_t)N + 1) * sizeof(long) +
+                        (cityMatrix != NULL ? (size_t)N * ((size_t)N * sizeof(int) + sizeof(int *)) : 0),
+                        "Reading the adjacency matrix");
+            adjacency = (int *)realloc(adjacency, *capacity * sizeof(int));
+            if (weight != NULL)
+                weight = (int *)realloc(weight, *capacity * sizeof(int));
+        }
+
+        // The costs are only kept once a cell other than 1 is found
+        if (row[j] != 1 && weight == NULL) {
+            long e;
+            weight = (int *)malloc(*capacity * sizeof(int));
+            for (e = 0; e < edgeCount; e++)
+                weight[e] = 1;
+        }
+        if (weight != NULL)
+            weight[edgeCount] = row[j];
+        adjacency[edgeCount++] = j;
+    }
+    rowStart[city + 1] = edgeCount;
+}
+
+void startDeadline(void) {
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    deadline.tv_sec += (time_t)timeLimit;
+    deadline.tv_nsec += (long)((timeLimit - (time_t)timeLimit) * 1e9);
+    if (deadline.tv_nsec >= 1000000000L) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000L;
+    }
+    cancelled = 0;
+}
+
+int deadlinePassed(void) {
+    struct timespec now;
+
+    if (timeLimit <= 0)
+        return 0;
+    if (cancelled)
+        return 1;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    if (now.tv_sec > deadline.tv_sec || (now.tv_sec == deadline.tv_sec && now.tv_nsec >= deadline.tv_nsec))
+        cancelled = 1;
+    return cancelled;
+}
+
+void reportDeadline(const char *what) {
+    if (!cancelled)
+        return;
+
+    fprintf(stderr, "Time limit of %g seconds reached: %s.\n", timeLimit, what);
+    timedOut = 1;
+}
+
+void checkMemory(size_t bytes, const char *what) {
+    if (memLimit > 0 && bytes > memLimit) {
+        fprintf(stderr, "Error: %s needs about %zu bytes, more than the --mem-limit of %zu bytes.\n", what, bytes, memLimit);
+        exit(EXIT_FAILURE);
+    }
+}
+
+void expandRow(int city, int *row) {
+    long e;
+    memset(row, 0, N * sizeof(int));
+    for (e = rowStart[city]; e < rowStart[city + 1]; e++)
+        row[adjacency[e]] = weight != NULL ? weight[e] : 1;
+}
+
+int findComponents(int *component) {
+    int *order = (int *)malloc((size_t)N * sizeof(int)); // The order each city was reached in, -1 if not yet
+    int *low = (int *)malloc((size_t)N * sizeof(int)); // The lowest order reachable from the search subtree
+    int *stack = (int *)malloc((size_t)N * sizeof(int)); // The cities not yet assigned to a component
+    int *callCity = (int *)malloc((size_t)N * sizeof(int)); // The search stack which replaces recursion
+    long *callNext = (long *)malloc((size_t)N * sizeof(long)); // The next neighbor to visit for each search city
+    unsigned char *onStack = (unsigned char *)calloc((size_t)N / 8 + 1, 1);
+    int counter = 0, stackSize = 0, callDepth, s, components = 0;
+
+    for (s = 0; s < N; s++)
+        order[s] = -1;
+
+    for (s = 0; s < N; s++) {
+        if (order[s] != -1)
+            continue;
+
+        order[s] = low[s] = counter++;
+        stack[stackSize++] = s;
+        onStack[s / 8] |= 1 << (s % 8);
+        callCity[0] = s;
+        callNext[0] = rowStart[s];
+        callDepth = 1;
+
+        while (callDepth > 0) {
+            int u = callCity[callDepth - 1];
+
+            if (callNext[callDepth - 1] < rowStart[u + 1]) {
+                int v = adjacency[callNext[callDepth - 1]++];
+
+                if (order[v] == -1) {
+                    order[v] = low[v] = counter++;
+                    stack[stackSize++] = v;
+                    onStack[v / 8] |= 1 << (v % 8);
+                    callCity[callDepth] = v;
+                    callNext[callDepth] = rowStart[v];
+                    callDepth++;
+                }
+                else if ((onStack[v / 8] & (1 << (v % 8))) && order[v] < low[u]) {
+                    low[u] = order[v];
+                }
+                continue;
+            }
+
+            // All the neighbors are done: u either roots a component or passes its low up
+            if (low[u] == order[u]) {
+                int v;
+                do {
+                    v = stack[--stackSize];
+                    onStack[v / 8] &= ~(1 << (v % 8));
+                    component[v] = components;
+                } while (v != u);
+
+                components++;
+            }
+
+            callDepth--;
+            if (callDepth > 0 && low[u] < low[callCity[callDepth - 1]])
+                low[callCity[callDepth - 1]] = low[u];
+        }
+    }
+
+    free(order);
+    free(low);
+    free(stack);
+    free(callCity);
+    free(callNext);
+    free(onStack);
+    return components;
+}
+
+long countComponents(long *largest) {
+    int *component = (int *)malloc(((size_t)N + 1) * sizeof(int));
+    int components = findComponents(component), u;
+    long *size = (long *)calloc((size_t)components + 1, sizeof(long));
+
+    *largest = 0;
+    for (u = 0; u < N; u++) {
+        if (++size[component[u]] > *largest)
+            *largest = size[component[u]];
+    }
+
+    free(component);
+    free(size);
+    return components;
+}
+
+void printGraphStats(void) {
+    size_t listBytes = ((size_t)N + 1) * sizeof(long) + (size_t)edgeCount * sizeof(int) * (weight != NULL ? 2 : 1);
+    long largest;
+
+    fprintf(stderr, "Cities: %d\n", N);
+    fprintf(stderr, "Connections: %ld\n", edgeCount);
+    fprintf(stderr, "Adjacency lists: %zu bytes (%.2f bytes per connection)\n", listBytes,
+            edgeCount > 0 ? (double)listBytes / edgeCount : 0.0);
+    if (cityMatrix != NULL)
+        fprintf(stderr, "Adjacency matrix: %zu bytes\n", (size_t)N * N * sizeof(int) + (size_t)N * sizeof(int *));
+    else
+        fprintf(stderr, "Adjacency matrix: not kept\n");
+
+    long components = countComponents(&largest);
+    fprintf(stderr, "Strongly connected components: %ld (largest: %ld cities)\n", components, largest);
+}
+
+int lowestBit(uint64_t bits) {
+#if defined(__GNUC__)
+    return __builtin_ctzll(bits);
+#else
+    static const int position[64] = {
+        0, 1, 48, 2, 57, 49, 28, 3, 61, 58, 50, 42, 38, 29, 17, 4,
+        62, 55, 59, 36, 53, 51, 43, 22, 45, 39, 33, 30, 24, 18, 12, 5,
+        63, 47, 56, 27, 60, 41, 37, 16, 54, 35, 52, 21, 44, 32, 23, 11,
+        46, 26, 40, 15, 34, 20, 31, 10, 25, 14, 19, 9, 13, 8, 7, 6
+    };
+    return position[((bits & (~bits + 1)) * 0x03f79d71b4cb0a89ULL) >> 58];
+#endif
+}
+
+int countBits(uint64_t bits) {
+#if defined(__GNUC__)
+    return __builtin_popcountll(bits);
+#else
+    bits = bits - ((bits >> 1) & 0x5555555555555555ULL);
+    bits = (bits & 0x3333333333333333ULL) + ((bits >> 2) & 0x3333333333333333ULL);
+    bits = (bits + (bits >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    return (int)((bits * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+void buildAdjacencyBits(void) {
+    size_t words = ((size_t)N + 63) / 64;
+    long e;
+    int u;
+
+    if (adjacencyBits != NULL)
+        return;
+
+    adjacencyBits = (uint64_t *)calloc((size_t)N * words + 1, sizeof(uint64_t));
+    for (u = 0; u < N; u++) {
+        for (e = rowStart[u]; e < rowStart[u + 1]; e++)
+            adjacencyBits[u * words + adjacency[e] / 64] |= (uint64_t)1 << (adjacency[e] % 64);
+    }
+}
+
+void buildIncoming(void) {
+    int *costs;
+
+    if (incomingStart != NULL)
+        return;
+
+    buildReverse(&incomingStart, &incoming, &costs);
+    free(costs);
+}
+
+void reportDirections(void) {
+    int level;
+
+    if (!statsOutput || activeEngine != ENGINE_BFS)
+        return;
+
+    for (level = 1; level < 64; level++) {
+        if (directionCount[level][0] + directionCount[level][1] > 0)
+            fprintf(stderr, "Level %d%s: %ld top-down, %ld bottom-up\n", level, level == 63 ? " and later" : "",
+                    directionCount[level][0], directionCount[level][1]);
+        directionCount[level][0] = directionCount[level][1] = 0;
+    }
+}
+
+size_t engineBytes(int engine, int rows, int threads) {
+    size_t words = ((size_t)N + 63) / 64;
+    size_t bytes = 0;
+
+    switch (engine) {
+        case ENGINE_ROUNDS:
+            // The closure and its previous round, as int rows
+            bytes = 2 * (size_t)rows * ((size_t)N * sizeof(int) + sizeof(int *));
+            break;
+        case ENGINE_BITSET:
+            // The adjacency bits, and the closure, previous round and current round bits of every row
+            bytes = (size_t)N * words * 8 + 3 * (size_t)rows * words * 8;
+            break;
+        case ENGINE_BFS:
+            // The seen marks and two rounds of cities per thread
+            bytes = (size_t)threads * 3 * (size_t)N * sizeof(int);
+            break;
+        case ENGINE_CHAINS:
+            // The components and chains, the labels, and a row of bits per thread
+            bytes = 6 * ((size_t)N + 1) * sizeof(int) + (size_t)componentCount * chainCount * sizeof(int) +
+                    (size_t)threads * words * 8;
+            break;
+    }
+
+    // The buffers of the output formats
+    if (matrixOutput)
+        bytes += (size_t)rows * (((size_t)N + 7) / 8) + (size_t)threads * (2 * (size_t)N + 1);
+    if (arrowOutput)
+        bytes += (size_t)threads * 6 * 4 * ARROW_BATCH;
+    if (compressOutput)
+        bytes += (size_t)threads * 12 * CLZ_BLOCK; // The stage buffers, the match finder table and the parsed pairs
+    return bytes;
+}
+
+size_t physicalMemory(void) {
+    long pages = sysconf(_SC_PHYS_PAGES);
+    long pageSize = sysconf(_SC_PAGESIZE);
+    return pages > 0 && pageSize > 0 ? (size_t)pages * (size_t)pageSize : (size_t)-1;
+}
+
+void planClosure(int rows, int threads) {
+    size_t loaded = ((size_t)N + 1) * sizeof(long) + (size_t)edgeCount * sizeof(int);
+    if (cityMatrix != NULL)
+        loaded += (size_t)N * ((size_t)N * sizeof(int) + sizeof(int *));
+
+    size_t budget = memLimit > 0 ? memLimit : physicalMemory();
+    int engine = closureEngine;
+
+    if (engine == ENGINE_CHAINS && arrowOutput == 2) {
+        fprintf(stderr, "Error: The chains engine does not find the number of hops for --arrow=hops.\n");
+        exit(EXIT_FAILURE);
+    }
+    // The chains list the pairs of a source in ascending order, so they are only chosen when any order was allowed
+    if (engine == ENGINE_CHAINS || (engine == ENGINE_FASTEST && N >= CHAIN_CITIES && arrowOutput != 2)) {
+        buildChains();
+        if (statsOutput)
+            fprintf(stderr, "Chains: %d for %d components\n", chainCount, componentCount);
+
+        // A few chains make the labels of a city shorter than any row, on hierarchical networks
+        if (engine == ENGINE_FASTEST && (long)chainCount * 64 <= N && loaded + engineBytes(ENGINE_CHAINS, rows, threads) <= budget)
+            engine = ENGINE_CHAINS;
+    }
+
+    if (engine == ENGINE_AUTO || engine == ENGINE_FASTEST) {
+        int fastest = engine == ENGINE_FASTEST;
+
+        // The bitset engine keeps the order of the rounds; the search per source city needs the least memory
+        engine = loaded + engineBytes(ENGINE_BITSET, rows, threads) <= budget ? ENGINE_BITSET : ENGINE_BFS;
+
+        // Both reach the same cities from a source: the bitset engine goes through a row of words for
+        // each of them, the search through their connections, so the tuning profile says which is faster.
+        // The search lists the pairs source after source, so the profile only decides when that order was allowed
+        if (fastest && engine == ENGINE_BITSET && N > 0 && loadTuning()) {
+            double words = ((size_t)N + 63) / 64;
+            double degree = (double)edgeCount / N;
+            double size = log2(N);
+            if (tuneCost[1][0] + degree * tuneCost[1][1] + size * tuneCost[1][2] <
+                tuneCost[0][0] + words * tuneCost[0][1] + size * tuneCost[0][2])
+                engine = ENGINE_BFS;
+        }
+    }
+    if (engine == ENGINE_ROUNDS && cityMatrix == NULL) {
+        fprintf(stderr, "Error: The rounds engine needs the adjacency matrix, which is not kept for this input.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    size_t needed = loaded + engineBytes(engine, rows, threads);
+    if (memLimit > 0 && needed > memLimit) {
+        fprintf(stderr, "Error: The R* table needs about %zu bytes with the %s engine (%zu for the network), "
+                "more than the --mem-limit of %zu bytes.\n", needed, engineNames[engine], loaded, memLimit);
+        exit(EXIT_FAILURE);
+    }
+
+    if (engine == ENGINE_BITSET)
+        buildAdjacencyBits();
+    if (engine == ENGINE_CHAINS)
+        buildChainLabels();
+    // The bottom-up rounds are only a speed up, so they are left out when they do not fit
+    size_t bottomUp = ((size_t)N + 1) * sizeof(long) + (size_t)edgeCount * sizeof(int) +
+                      (size_t)threads * (4 * (size_t)N * sizeof(int) + ((size_t)N + 63) / 64 * 8);
+    if (engine == ENGINE_BFS && needed + bottomUp <= budget)
+        buildIncoming();
+    if (engine == ENGINE_BITSET && bandwidthOutput)
+        memoryBandwidth();
+
+    activeEngine = engine;
+    if (statsOutput)
+        fprintf(stderr, "Engine: %s (about %zu bytes)\n", engineNames[engine], needed);
+}
+
+long closeRange(int **cityMatrix, int first, int last, PairFunction emit, void *context) {
+    switch (activeEngine) {
+        case ENGINE_ROUNDS:
+            return closeRows(cityMatrix, first, last, emit, context);
+        case ENGINE_BITSET:
+            return closeRowsBits(first, last, emit, context);
+        case ENGINE_CHAINS:
+            return closeRowsChains(first, last, emit, context);
+        default:
+            return closeRowsBFS(first, last, emit, context);
+    }
+}
+
+long closeRowsBits(int first, int last, PairFunction emit, void *context) {
+    size_t words = ((size_t)N + 63) / 64;
+    size_t rows = last - first;
+    uint64_t *closure = (uint64_t *)calloc(rows * words + 1, sizeof(uint64_t)); // The cities reached from each source
+    uint64_t *previous = (uint64_t *)calloc(rows * words + 1, sizeof(uint64_t)); // The cities found in the previous round
+    uint64_t *current = (uint64_t *)calloc(rows * words + 1, sizeof(uint64_t)); // The cities found in this round
+    long pairs = 0, e;
+    size_t x, y;
+    int u, round, repeat;
+
+    if (closure == NULL || previous == NULL || current == NULL) {
+        fprintf(stderr, "Error: Not enough memory for the bitset engine.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    // The direct connections come first, including one from a city to itself
+    for (u = first; u < last; u++) {
+        uint64_t *reached = closure + (u - first) * words;
+        uint64_t *found = previous + (u - first) * words;
+
+        for (e = rowStart[u]; e < rowStart[u + 1]; e++) {
+            emit(context, u, adjacency[e], 0);
+            pairs++;
+            reached[adjacency[e] / 64] |= (uint64_t)1 << (adjacency[e] % 64);
+            found[adjacency[e] / 64] |= (uint64_t)1 << (adjacency[e] % 64);
+        }
+        // The city itself is never added by a later round
+        reached[u / 64] |= (uint64_t)1 << (u % 64);
+    }
+    PROGRESS_ADD(progressPairs, pairs);
+
+    char *complete = (char *)calloc(rows + 1, 1); // Whether a row found nothing new in a round
+    repeat = 1;
+    for (round = 1; repeat && !deadlinePassed(); round++) {
+        struct timespec start;
+        long expanded = 0; // The rows of the adjacency matrix combined in this round
+
+        if (bandwidthOutput)
+            clock_gettime(CLOCK_MONOTONIC, &start);
+        repeat = 0;
+        memset(current, 0, rows * words * sizeof(uint64_t));
+
+        PROGRESS_SET(progressRound, round);
+        for (u = first; u < last && !deadlinePassed(); u++) {
+            long rowPairs = pairs;
+            PROGRESS_ADD(progressSteps, 1);
+            uint64_t *reached = closure + (u - first) * words;
+            uint64_t *found = previous + (u - first) * words;
+            uint64_t *added = current + (u - first) * words;
+
+            // The cities of the previous round in ascending order, like the rounds of closeRows
+            for (y = 0; y < words; y++) {
+                uint64_t via = found[y];
+                while (via != 0) {
+                    size_t v = y * 64 + lowestBit(via);
+                    const uint64_t *next = adjacencyBits + v * words;
+                    via &= via - 1;
+                    expanded++;
+
+                    for (x = 0; x < words; x++) {
+                        uint64_t fresh = next[x] & ~reached[x];
+                        if (fresh == 0)
+                            continue;
+
+                        reached[x] |= fresh;
+                        added[x] |= fresh;
+                        repeat = 1;
+                        while (fresh != 0) {
+                            emit(context, u, (int)(x * 64 + lowestBit(fresh)), round);
+                            pairs++;
+                            fresh &= fresh - 1;
+                        }
+                    }
+                }
+            }
+
+            // A row without new pairs in a round is complete
+            PROGRESS_ADD(progressPairs, pairs - rowPairs);
+            if (pairs == rowPairs && !complete[u - first]) {
+                complete[u - first] = 1;
+                PROGRESS_ADD(progressRows, 1);
+            }
+        }
+
+        // Every combined row reads its words and those of the closure; every round clears and scans a round of bits
+        if (bandwidthOutput)
+            reportBandwidth(first, last, round, (double)expanded * words * 16 + (double)rows * words * 16,
+                            (double)expanded * words, &start);
+
+        uint64_t *swap = previous;
+        previous = current;
+        current = swap;
+    }
+
+    free(complete);
+    free(closure);
+    free(previous);
+    free(current);
+    return pairs;
+}
+
+long closeRowsBFS(int first, int last, PairFunction emit, void *context) {
+    int *seen = (int *)malloc((size_t)N * sizeof(int)); // The last source city that reached each city
+    int *frontier = (int *)malloc((size_t)N * sizeof(int)); // The cities found in the previous round
+    int *next = (int *)malloc((size_t)N * sizeof(int)); // The cities found in the current round
+    size_t words = ((size_t)N + 63) / 64;
+    uint64_t *inFrontier = NULL; // The cities of the previous round as bits, for the bottom-up rounds
+    int *position = NULL, *parent = NULL, *bucket = NULL; // The order of the cities of a bottom-up round
+    long pairs = 0, e;
+    int u, i;
+
+    if (incomingStart != NULL) {
+        inFrontier = (uint64_t *)calloc(words + 1, sizeof(uint64_t));
+        position = (int *)malloc((size_t)N * sizeof(int));
+        parent = (int *)malloc((size_t)N * sizeof(int));
+        bucket = (int *)malloc(((size_t)N + 1) * sizeof(int));
+    }
+
+    for (i = 0; i < N; i++)
+        seen[i] = -1;
+
+    for (u = first; u < last && !deadlinePassed(); u++) {
+        int frontierSize = 0, previousSize = 1, nextSize, round, bottomUp = 0;
+        long rowPairs = pairs;
+        long unexplored = edgeCount; // The connections into the cities not reached yet
+
+        // The direct connections come first, including one from the city to itself
+        for (e = rowStart[u]; e < rowStart[u + 1]; e++) {
+            int w = adjacency[e];
+            emit(context, u, w, 0);
+            pairs++;
+            seen[w] = u;
+            frontier[frontierSize++] = w;
+            if (incomingStart != NULL)
+                unexplored -= incomingStart[w + 1] - incomingStart[w];
+        }
+        // The city itself is never added by a later round
+        if (incomingStart != NULL && seen[u] != u)
+            unexplored -= incomingStart[u + 1] - incomingStart[u];
+        seen[u] = u;
+
+        for (round = 1; frontierSize > 0 && !deadlinePassed(); round++) {
+            // Like the rounds of closeRows, the cities of the previous round are visited in ascending order
+            qsort(frontier, frontierSize, sizeof(int), compareCities);
+
+            if (incomingStart != NULL)
+                bottomUp = chooseDirection(frontier, frontierSize, previousSize, unexplored, bottomUp);
+            if (statsOutput)
+                PROGRESS_ADD(directionCount[round < 63 ? round : 63][bottomUp], 1);
+
+            nextSize = 0;
+            if (!bottomUp) {
+                for (i = 0; i < frontierSize; i++) {
+                    int v = frontier[i];
+                    for (e = rowStart[v]; e < rowStart[v + 1]; e++) {
+                        int w = adjacency[e];
+                        if (seen[w] != u) {
+                            seen[w] = u;
+                            emit(context, u, w, round);
+                            pairs++;
+                            next[nextSize++] = w;
+                        }
+                    }
+                }
+            }
+            else {
+                int w;
+
+                // The smallest city of the frontier leading to a city is the one the top-down round reaches it from
+                nextSize = bottomUpLevel(frontier, frontierSize, seen, u, parent, next, inFrontier);
+
+                // Sorting the cities by the position of that city gives the order of the top-down round
+                for (i = 0; i < frontierSize; i++) {
+                    position[frontier[i]] = i;
+                    bucket[i] = 0;
+                }
+                bucket[frontierSize] = 0;
+                for (i = 0; i < nextSize; i++)
+                    bucket[position[parent[next[i]]] + 1]++;
+                for (i = 0; i < frontierSize; i++)
+                    bucket[i + 1] += bucket[i];
+                for (i = 0; i < nextSize; i++)
+                    frontier[bucket[position[parent[next[i]]]]++] = next[i];
+                for (i = 0; i < nextSize; i++) {
+                    w = frontier[i];
+                    seen[w] = u;
+                    emit(context, u, w, round);
+                    pairs++;
+                    next[i] = w;
+                }
+            }
+            if (incomingStart != NULL) {
+                for (i = 0; i < nextSize; i++)
+                    unexplored -= incomingStart[next[i] + 1] - incomingStart[next[i]];
+            }
+
+            int *swap = frontier;
+            frontier = next;
+            next = swap;
+            previousSize = frontierSize;
+            frontierSize = nextSize;
+        }
+
+        PROGRESS_ADD(progressPairs, pairs - rowPairs);
+        PROGRESS_ADD(progressRows, 1);
+    }
+
+    free(seen);
+    free(frontier);
+    free(next);
+    free(inFrontier);
+    free(position);
+    free(parent);
+    free(bucket);
+    return pairs;
+}
+
+long progressAdd(PROGRESS_LONG *counter, long amount) {
+    long value;
+
+    pthread_mutex_lock(&progressLock);
+    value = *counter += amount;
+    pthread_mutex_unlock(&progressLock);
+    return value;
+}
+
+void progressSet(PROGRESS_LONG *counter, long value) {
+    pthread_mutex_lock(&progressLock);
+    *counter = value;
+    pthread_mutex_unlock(&progressLock);
+}
+
+void startProgress(void) {
+    PROGRESS_SET(progressPairs, 0);
+    PROGRESS_SET(progressRows, 0);
+    PROGRESS_SET(progressRound, 0);
+    PROGRESS_SET(progressSteps, 0);
+    clock_gettime(CLOCK_MONOTONIC, &progress.start);
+
+    if (!progressOutput)
+        return;
+
+    // The sampler wakes up on the same clock as the start time
+    pthread_condattr_t attributes;
+    pthread_condattr_init(&attributes);
+    pthread_condattr_setclock(&attributes, CLOCK_MONOTONIC);
+    pthread_mutex_init(&progress.lock, NULL);
+    pthread_cond_init(&progress.wake, &attributes);
+    pthread_condattr_destroy(&attributes);
+    progress.stop = 0;
+    progress.running = pthread_create(&progress.thread, NULL, progressThread, NULL) == 0;
+}
+
+void stopProgress(void) {
+    struct timespec now;
+    char line[256];
+
+    if (!progressOutput)
+        return;
+
+    if (progress.running) {
+        pthread_mutex_lock(&progress.lock);
+        progress.stop = 1;
+        pthread_cond_signal(&progress.wake);
+        pthread_mutex_unlock(&progress.lock);
+        pthread_join(progress.thread, NULL);
+        progress.running = 0;
+    }
+    pthread_mutex_destroy(&progress.lock);
+    pthread_cond_destroy(&progress.wake);
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    snprintf(line, sizeof(line), "Progress: %ld pairs of %ld/%d source cities in %.1f s",
+             PROGRESS_GET(progressPairs), PROGRESS_GET(progressRows), N,
+             (double)(now.tv_sec - progress.start.tv_sec) + (now.tv_nsec - progress.start.tv_nsec) / 1e9);
+    writeProgress(line);
+}
+
+void *progressThread(void *arg) {
+    struct timespec wakeAt, now;
+    char line[256], eta[32];
+    long lastPairs = 0, lastSteps = 0;
+    double lastTime = 0;
+    (void)arg;
+
+    pthread_mutex_lock(&progress.lock);
+    wakeAt = progress.start;
+    while (!progress.stop) {
+        wakeAt.tv_sec++;
+        while (!progress.stop && pthread_cond_timedwait(&progress.wake, &progress.lock, &wakeAt) == 0)
+            ;
+        if (progress.stop)
+            break;
+
+        // The counters are read without stopping the engines
+        long pairs = PROGRESS_GET(progressPairs);
+        long rows = PROGRESS_GET(progressRows);
+        int round = (int)PROGRESS_GET(progressRound);
+        long steps = PROGRESS_GET(progressSteps);
+
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        double elapsed = (double)(now.tv_sec - progress.start.tv_sec) + (now.tv_nsec - progress.start.tv_nsec) / 1e9;
+        double rate = elapsed > lastTime ? (pairs - lastPairs) / (elapsed - lastTime) : 0;
+
+        if (activeEngine == ENGINE_BFS || activeEngine == ENGINE_CHAINS) {
+            if (rows > 0)
+                snprintf(eta, sizeof(eta), "%.0f s", elapsed * (N - rows) / rows);
+            else
+                snprintf(eta, sizeof(eta), "unknown");
+            snprintf(line, sizeof(line), "Progress: %ld/%d source cities, %ld pairs, %.0f pairs/s, ETA %s",
+                     rows, N, pairs, rate, eta);
+        }
+        else {
+            // Every round goes through all the source cities
+            long inRound = steps - (long)(round > 0 ? round - 1 : 0) * N;
+            inRound = inRound < 0 ? 0 : (inRound > N ? N : inRound);
+            double stepRate = elapsed > lastTime ? (steps - lastSteps) / (elapsed - lastTime) : 0;
+
+            if (stepRate > 0)
+                snprintf(eta, sizeof(eta), "%.0f s", (N - inRound) / stepRate);
+            else
+                snprintf(eta, sizeof(eta), "unknown");
+            snprintf(line, sizeof(line), "Progress: round %d at %ld/%d source cities, %ld complete, %ld pairs, "
+                     "%.0f pairs/s, ETA %s for this round", round, inRound, N, rows, pairs, rate, eta);
+        }
+
+        pthread_mutex_unlock(&progress.lock);
+        writeProgress(line);
+        pthread_mutex_lock(&progress.lock);
+
+        lastPairs = pairs;
+        lastSteps = steps;
+        lastTime = elapsed;
+    }
+    pthread_mutex_unlock(&progress.lock);
+    return NULL;
+}
+
+void writeProgress(const char *line) {
+    if (progressFile == NULL) {
+        fprintf(stderr, "%s\n", line);
+        return;
+    }
+
+    // The status file always holds the latest line only
+    FILE *file = fopen(progressFile, "w");
+    if (file == NULL) {
+        fprintf(stderr, "Error opening the progress file %s\n", progressFile);
+        return;
+    }
+    fprintf(file, "%s\n", line);
+    fclose(file);
+}
+
+void skipPair(void *context, int source, int destination, int round) {
+    (void)context;
+    (void)source;
+    (void)destination;
+    (void)round;
+}
+
+char *tuningPath(void) {
+    const char *home = getenv("HOME");
+    const char *name = home != NULL && home[0] != '\0' ? "/.cityLink.tune" : "cityLink.tune";
+    if (home == NULL || home[0] == '\0')
+        home = "";
+
+    char *path = (char *)malloc(strlen(home) + strlen(name) + 1);
+    strcpy(path, home);
+    strcat(path, name);
+    return path;
+}
+
+int loadTuning(void) {
+    if (tuneLoaded != 0)
+        return tuneLoaded > 0;
+
+    char *path = tuningPath();
+    FILE *file = fopen(path, "r");
+    tuneLoaded = -1;
+
+    if (file != NULL) {
+        if (fscanf(file, "cityLink tuning profile bitset_ns %lf word_ns %lf bitset_log_ns %lf bfs_ns %lf edge_ns %lf bfs_log_ns %lf",
+                   &tuneCost[0][0], &tuneCost[0][1], &tuneCost[0][2], &tuneCost[1][0], &tuneCost[1][1], &tuneCost[1][2]) == 6)
+            tuneLoaded = 1;
+        fclose(file);
+    }
+    free(path);
+    return tuneLoaded > 0;
+}
+
+void implementAutotune(void) {
+    static const int sizes[] = {1024, 4096, 16384};
+    static const int degrees[] = {2, 16, 64};
+    const int sources = 128; // The source cities timed in each network
+    double normal[2][3][4] = {{{0}}}; // The normal equations of the least squares fit of each engine
+    uint64_t state = 0x9E3779B97F4A7C15ULL;
+    size_t s, d;
+    long e;
+    int k, i, j;
+
+    // The generated networks replace the loaded one, and are timed without the --time-limit
+    double limit = timeLimit;
+    freeGraph();
+    timeLimit = 0;
+
+    printf("Autotune\n");
+    for (s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        for (d = 0; d < sizeof(degrees) / sizeof(degrees[0]); d++) {
+            long count = (long)sizes[s] * degrees[d];
+            int *from = (int *)malloc(count * sizeof(int));
+            int *to = (int *)malloc(count * sizeof(int));
+            struct timespec start, middle, end;
+
+            // A random network with the given number of connections per city (xorshift)
+            N = sizes[s];
+            for (e = 0; e < count; e++) {
+                state ^= state << 13;
+                state ^= state >> 7;
+                state ^= state << 17;
+                from[e] = (int)(e / degrees[d]);
+                to[e] = (int)(state % (uint64_t)N);
+            }
+            buildGraph(from, to, NULL, count);
+            free(from);
+            free(to);
+            buildAdjacencyBits();
+
+            clock_gettime(CLOCK_MONOTONIC, &start);
+            long pairs = closeRowsBits(0, sources, skipPair, NULL);
+            clock_gettime(CLOCK_MONOTONIC, &middle);
+            closeRowsBFS(0, sources, skipPair, NULL);
+            clock_gettime(CLOCK_MONOTONIC, &end);
+
+            double bitsNs = (middle.tv_sec - start.tv_sec) * 1e9 + (middle.tv_nsec - start.tv_nsec);
+            double bfsNs = (end.tv_sec - middle.tv_sec) * 1e9 + (end.tv_nsec - middle.tv_nsec);
+            double degree = (double)edgeCount / N;
+
+            // Every city reached from a source is expanded once by both engines, going through
+            // a row of words or through its connections
+            double x[2][3] = {{1, ((size_t)N + 63) / 64, log2(N)}, {1, degree, log2(N)}};
+            double y[2] = {bitsNs / (pairs > 0 ? pairs : 1), bfsNs / (pairs > 0 ? pairs : 1)};
+            for (k = 0; k < 2; k++) {
+                for (i = 0; i < 3; i++) {
+                    for (j = 0; j < 3; j++)
+                        normal[k][i][j] += x[k][i] * x[k][j];
+                    normal[k][i][3] += x[k][i] * y[k];
+                }
+            }
+            printf("%d cities, %d connections per city: bitset %.1f ms, bfs %.1f ms\n",
+                   N, degrees[d], bitsNs / 1e6, bfsNs / 1e6);
+
+            freeGraph();
+        }
+    }
+    N = 0;
+    timeLimit = limit;
+
+    // Solve the normal equations of each engine by Gaussian elimination
+    for (k = 0; k < 2; k++) {
+        double (*m)[4] = normal[k];
+        for (i = 0; i < 3; i++) {
+            for (j = i + 1; j < 3; j++) {
+                double factor = m[i][i] != 0 ? m[j][i] / m[i][i] : 0;
+                int c;
+                for (c = i; c < 4; c++)
+                    m[j][c] -= factor * m[i][c];
+            }
+        }
+        for (i = 2; i >= 0; i--) {
+            double value = m[i][3];
+            for (j = i + 1; j < 3; j++)
+                value -= m[i][j] * tuneCost[k][j];
+            tuneCost[k][i] = m[i][i] != 0 ? value / m[i][i] : 0;
+        }
+    }
+    tuneLoaded = 1;
+
+    char *path = tuningPath();
+    FILE *file = fopen(path, "w");
+    if (file == NULL) {
+        fprintf(stderr, "Error opening the output file \n");
+        exit(EXIT_FAILURE);
+    }
+    fprintf(file, "cityLink tuning profile\n");
+    fprintf(file, "bitset_ns %.6f\n", tuneCost[0][0]);
+    fprintf(file, "word_ns %.6f\n", tuneCost[0][1]);
+    fprintf(file, "bitset_log_ns %.6f\n", tuneCost[0][2]);
+    fprintf(file, "bfs_ns %.6f\n", tuneCost[1][0]);
+    fprintf(file, "edge_ns %.6f\n", tuneCost[1][1]);
+    fprintf(file, "bfs_log_ns %.6f\n", tuneCost[1][2]);
+    fclose(file);
+    printf("Saving %s...\n", path);
+    free(path);
+}
+
+double memoryBandwidth(void) {
+    size_t count = (size_t)1 << 22; // 32 MB per array, well beyond the caches
+    struct timespec start, end;
+    double best[2] = {0, 0};
+    int k, pass;
+    size_t i;
+
+    if (peakBandwidth > 0)
+        return peakBandwidth;
+
+    // Three arrays must fit in half of the --mem-limit
+    while (memLimit > 0 && count > 4096 && 3 * count * sizeof(double) > memLimit / 2)
+        count /= 2;
+
+    double *a = (double *)malloc(count * sizeof(double));
+    double *b = (double *)malloc(count * sizeof(double));
+    double *c = (double *)malloc(count * sizeof(double));
+    if (a == NULL || b == NULL || c == NULL) {
+        fprintf(stderr, "Error: Not enough memory to measure the memory bandwidth.\n");
+        exit(EXIT_FAILURE);
+    }
+    for (i = 0; i < count; i++) {
+        a[i] = 1.0;
+        b[i] = 2.0;
+        c[i] = 0.0;
+    }
+
+    // The best of a few passes of copy (c = a) and triad (c = a + 3 b), like STREAM
+    for (pass = 0; pass < 5; pass++) {
+        for (k = 0; k < 2; k++) {
+            clock_gettime(CLOCK_MONOTONIC, &start);
+            if (k == 0) {
+                for (i = 0; i < count; i++)
+                    c[i] = a[i];
+            }
+            else {
+                for (i = 0; i < count; i++)
+                    c[i] = a[i] + 3.0 * b[i];
+            }
+            clock_gettime(CLOCK_MONOTONIC, &end);
+
+            double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+            double bytes = (double)count * sizeof(double) * (k == 0 ? 2 : 3);
+            if (seconds > 0 && bytes / seconds > best[k])
+                best[k] = bytes / seconds;
+        }
+    }
+
+    // Use the arrays, so that the passes are not optimized away
+    if (c[count / 2] != 7.0)
+        fprintf(stderr, "Warning: The memory bandwidth check gave a wrong result.\n");
+
+    free(a);
+    free(b);
+    free(c);
+
+    peakBandwidth = best[0] > best[1] ? best[0] : best[1];
+    fprintf(stderr, "Memory bandwidth: %.2f GB/s (copy %.2f GB/s, triad %.2f GB/s)\n",
+            peakBandwidth / 1e9, best[0] / 1e9, best[1] / 1e9);
+    return peakBandwidth;
+}
+
+void reportBandwidth(int first, int last, int round, double bytes, double operations, const struct timespec *start) {
+    struct timespec end;
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double seconds = (end.tv_sec - start->tv_sec) + (end.tv_nsec - start->tv_nsec) / 1e9;
+    if (seconds <= 0)
+        return;
+
+    fprintf(stderr, "Bitset round %d of cities %d-%d: %.2f s, %.2f GB/s (%.0f%% of peak), %.2f G word operations/s\n",
+            round, first, last - 1, seconds, bytes / seconds / 1e9,
+            peakBandwidth > 0 ? 100 * bytes / seconds / peakBandwidth : 0, operations / seconds / 1e9);
+}
+
+void loadCoordinates(void) {
+    int i;
+
+    if (latitude != NULL)
+        return;
+    if (coordinatesFile == NULL) {
+        fprintf(stderr, "Error: No coordinates given! Use --coords <file>.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    FILE *file = fopen(coordinatesFile, "r");
+    if (file == NULL) {
+        fprintf(stderr, "Error opening the coordinates file %s\n", coordinatesFile);
+        exit(EXIT_FAILURE);
+    }
+
+    latitude = (double *)malloc(((size_t)N + 1) * sizeof(double));
+    longitude = (double *)malloc(((size_t)N + 1) * sizeof(double));
+    planeX = (double *)malloc(((size_t)N + 1) * sizeof(double));
+    planeY = (double *)malloc(((size_t)N + 1) * sizeof(double));
+
+    double meanLatitude = 0;
+    for (i = 0; i < N; i++) {
+        if (fscanf(file, "%lf %lf", &latitude[i], &longitude[i]) != 2 ||
+            latitude[i] < -90 || latitude[i] > 90 || longitude[i] < -180 || longitude[i] > 180) {
+            fprintf(stderr, "Error: Failed to read the coordinates of city %d from %s.\n", i, coordinatesFile);
+            exit(EXIT_FAILURE);
+        }
+        meanLatitude += latitude[i] / N;
+    }
+    fclose(file);
+
+    // The grid is laid on the plane with the longitude shortened like on a map of the region
+    gridScale = cos(meanLatitude * RADIANS);
+    double right = 0, top = 0;
+    for (i = 0; i < N; i++) {
+        planeX[i] = longitude[i] * gridScale;
+        planeY[i] = latitude[i];
+        if (i == 0 || planeX[i] < gridLeft)
+            gridLeft = planeX[i];
+        if (i == 0 || planeY[i] < gridBottom)
+            gridBottom = planeY[i];
+        if (i == 0 || planeX[i] > right)
+            right = planeX[i];
+        if (i == 0 || planeY[i] > top)
+            top = planeY[i];
+    }
+
+    // About one city per cell
+    double area = (right - gridLeft) * (top - gridBottom);
+    gridCell = N > 0 && area > 0 ? sqrt(area / N) : 1;
+    if (gridCell <= 0)
+        gridCell = 1;
+    gridWidth = (int)((right - gridLeft) / gridCell) + 1;
+    gridHeight = (int)((top - gridBottom) / gridCell) + 1;
+    while ((long)gridWidth * gridHeight > 4L * N + 16) {
+        gridCell *= 2;
+        gridWidth = (int)((right - gridLeft) / gridCell) + 1;
+        gridHeight = (int)((top - gridBottom) / gridCell) + 1;
+    }
+
+    long cells = (long)gridWidth * gridHeight;
+    int *cellOf = (int *)malloc(((size_t)N + 1) * sizeof(int));
+    cellStart = (int *)calloc(cells + 1, sizeof(int));
+    cellCities = (int *)malloc(((size_t)N + 1) * sizeof(int));
+    for (i = 0; i < N; i++) {
+        int x = (int)((planeX[i] - gridLeft) / gridCell), y = (int)((planeY[i] - gridBottom) / gridCell);
+        cellOf[i] = y * gridWidth + x;
+        cellStart[cellOf[i] + 1]++;
+    }
+    long c;
+    for (c = 0; c < cells; c++)
+        cellStart[c + 1] += cellStart[c];
+
+    int *position = (int *)malloc((cells + 1) * sizeof(int));
+    memcpy(position, cellStart, (cells + 1) * sizeof(int));
+    for (i = 0; i < N; i++)
+        cellCities[position[cellOf[i]]++] = i;
+    free(position);
+    free(cellOf);
+}
+
+int snapCity(double pointLatitude, double pointLongitude) {
+    int best = -1, ring;
+    double bestDistance = 0;
+
+    if (N == 0) {
+        fprintf(stderr, "Error: There are no cities to snap to.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    double x = pointLongitude * gridScale, y = pointLatitude;
+    int cellX = (int)floor((x - gridLeft) / gridCell), cellY = (int)floor((y - gridBottom) / gridCell);
+
+    // Clamp the cell to the grid; the distance to it still bounds the rings
+    int startX = cellX < 0 ? 0 : (cellX >= gridWidth ? gridWidth - 1 : cellX);
+    int startY = cellY < 0 ? 0 : (cellY >= gridHeight ? gridHeight - 1 : cellY);
+    int outside = abs(cellX - startX) > abs(cellY - startY) ? abs(cellX - startX) : abs(cellY - startY);
+
+    for (ring = 0; ring <= gridWidth + gridHeight; ring++) {
+        int dx, dy;
+
+        // Cities in this ring are at least (ring - 1 - outside) cells away from the point
+        if (best >= 0 && (ring - 1 - outside) * gridCell > bestDistance)
+            break;
+
+        for (dy = -ring; dy <= ring; dy++) {
+            int cy = startY + dy;
+            if (cy < 0 || cy >= gridHeight)
+                continue;
+            for (dx = -ring; dx <= ring; dx++) {
+                int cx = startX + dx, k;
+                if (cx < 0 || cx >= gridWidth || (abs(dx) != ring && abs(dy) != ring))
+                    continue;
+
+                int cell = cy * gridWidth + cx;
+                for (k = cellStart[cell]; k < cellStart[cell + 1]; k++) {
+                    int city = cellCities[k];
+                    double distance = hypot(planeX[city] - x, planeY[city] - y);
+                    if (best < 0 || distance < bestDistance || (distance == bestDistance && city < best)) {
+                        best = city;
+                        bestDistance = distance;
+                    }
+                }
+            }
+        }
+    }
+    return best;
+}
+
+double cityDistance(int a, int b) {
+    double p1 = latitude[a] * RADIANS, p2 = latitude[b] * RADIANS;
+    double dp = p2 - p1, dl = (longitude[b] - longitude[a]) * RADIANS;
+    double h = sin(dp / 2) * sin(dp / 2) + cos(p1) * cos(p2) * sin(dl / 2) * sin(dl / 2);
+    return 2 * EARTH_RADIUS * asin(sqrt(h < 1 ? h : 1));
+}
+
+int findRoute(int source, int destination) {
+    long long *cost = (long long *)malloc(((size_t)N + 1) * sizeof(long long)); // The cheapest cost found to each city
+    int *parent = (int *)malloc(((size_t)N + 1) * sizeof(int)); // The city before each city on its route, -1 if not reached
+    unsigned char *settled = (unsigned char *)calloc((size_t)N + 1, 1);
+    double perKilometer = -1; // The smallest cost per kilometer of any connection
+    long e, settledCount = 0;
+    int u, found = 0;
+
+    loadCoordinates();
+
+    // The lower bound is only valid if no connection is cheaper per kilometer than this
+    for (u = 0; u < N; u++) {
+        for (e = rowStart[u]; e < rowStart[u + 1]; e++) {
+            if (linkCost(weight, e) < 0) {
+                fprintf(stderr, "Error: The connection %d -> %d has a negative cost.\n", u, adjacency[e]);
+                exit(EXIT_FAILURE);
+            }
+            double length = cityDistance(u, adjacency[e]);
+            if (length > 0 && (perKilometer < 0 || linkCost(weight, e) / length < perKilometer))
+                perKilometer = linkCost(weight, e) / length;
+        }
+    }
+    if (perKilometer < 0)
+        perKilometer = 0;
+
+    for (u = 0; u < N; u++)
+        parent[u] = -1;
+
+    Heap heap = {NULL, 0, 0};
+    HeapItem item;
+    cost[source] = 0;
+    parent[source] = source;
+    heapPush(&heap, (long long)(perKilometer * cityDistance(source, destination)), source, 0);
+
+    while (heapPop(&heap, &item)) {
+        int v = item.city;
+        if (settled[v])
+            continue;
+        settled[v] = 1;
+        settledCount++;
+
+        if (v == destination) {
+            found = 1;
+            break;
+        }
+        if ((settledCount & 0xFFFF) == 0 && deadlinePassed()) {
+            found = -1;
+            break;
+        }
+
+        for (e = rowStart[v]; e < rowStart[v + 1]; e++) {
+            int w = adjacency[e];
+            long long g = cost[v] + linkCost(weight, e);
+            if (settled[w] || (parent[w] >= 0 && g >= cost[w]))
+                continue;
+
+            cost[w] = g;
+            parent[w] = v;
+            heapPush(&heap, g + (long long)(perKilometer * cityDistance(w, destination)), w, 0);
+        }
+    }
+
+    if (found == 1) {
+        // Follow the parents back from the destination
+        long length = 0, i;
+        for (u = destination; u != source; u = parent[u])
+            length++;
+        int *path = (int *)malloc((length + 1) * sizeof(int));
+        for (u = destination, i = length; i >= 0; u = parent[u], i--)
+            path[i] = u;
+
+        printf("Yes Path Exists!\n");
+        for (i = 0; i <= length; i++)
+            printf(i < length ? "%d=>" : "%d\n", path[i]);
+        printf("Cost: %lld\n", cost[destination]);
+        free(path);
+    }
+    if (statsOutput)
+        fprintf(stderr, "Settled cities: %ld\n", settledCount);
+
+    free(heap.items);
+    free(cost);
+    free(parent);
+    free(settled);
+    return found;
+}
+
+// Function to print a route of findAlternatives with its number and cost
+void printRoute(const Route *route, int number) {
+    int i;
+    printf("Route %d, cost %lld:\n", number, route->cost[route->length - 1]);
+    for (i = 0; i < route->length; i++)
+        printf(i < route->length - 1 ? "%d=>" : "%d\n", route->city[i]);
+}
+
+// Function to check if two routes go through the same cities
+int sameRoute(const Route *a, const Route *b) {
+    return a->length == b->length && memcmp(a->city, b->city, a->length * sizeof(int)) == 0;
+}
+
+int findAlternatives(int source, int destination, int count) {
+    long long *toGoal = (long long *)malloc(((size_t)N + 1) * sizeof(long long)); // The cheapest cost from each city to the destination, -1 if it cannot reach it
+    int *toward = (int *)malloc(((size_t)N + 1) * sizeof(int)); // The next city on the cheapest route to the destination
+    long long *cost = (long long *)malloc(((size_t)N + 1) * sizeof(long long)); // The cheapest cost from the spur city in a spur search
+    int *parent = (int *)malloc(((size_t)N + 1) * sizeof(int)); // The city before each city in a spur search
+    int *seen = (int *)calloc((size_t)N + 1, sizeof(int)); // The spur search that reached each city last
+    int *done = (int *)calloc((size_t)N + 1, sizeof(int)); // The spur search that settled each city last
+    int *blocked = (int *)calloc((size_t)N + 1, sizeof(int)); // The spur search each city is on the root of
+    int *banned = (int *)calloc((size_t)N + 1, sizeof(int)); // The spur search that may not go from the spur city to each city
+    int *clear = (int *)calloc((size_t)N + 1, sizeof(int)); // The spur search that found the route in the tree from each city free (positive) or blocked (negative)
+    long *reverseStart, e, spurSearches = 0, settledCount = 0;
+    int *reverseList, *reverseWeight, u, found = 0, stamp = 0;
+
+    for (u = 0; u < N; u++) {
+        for (e = rowStart[u]; e < rowStart[u + 1]; e++) {
+            if (linkCost(weight, e) < 0) {
+                fprintf(stderr, "Error: The connection %d -> %d has a negative cost.\n", u, adjacency[e]);
+                exit(EXIT_FAILURE);
+            }
+        }
+        toGoal[u] = -1;
+    }
+
+    // The tree of the cheapest routes into the destination, over the reversed network
+    buildReverse(&reverseStart, &reverseList, &reverseWeight);
+    Heap heap = {NULL, 0, 0};
+    HeapItem item;
+    toGoal[destination] = 0;
+    toward[destination] = destination;
+    heapPush(&heap, 0, destination, 0);
+    while (heapPop(&heap, &item)) {
+        int v = item.city;
+        if (item.distance > toGoal[v])
+            continue;
+        for (e = reverseStart[v]; e < reverseStart[v + 1]; e++) {
+            int w = reverseList[e];
+            long long d = item.distance + linkCost(reverseWeight, e);
+            if (toGoal[w] < 0 || d < toGoal[w]) {
+                toGoal[w] = d;
+                toward[w] = v;
+                heapPush(&heap, d, w, 0);
+            }
+        }
+    }
+    free(reverseStart);
+    free(reverseList);
+    free(reverseWeight);
+
+    Route *routes = (Route *)malloc(count * sizeof(Route)); // The routes found, in order of cost
+    Route *candidates = NULL; // The routes that may come next
+    long candidateCount = 0, candidateCapacity = 0;
+    int routeCount = 0;
+
+    if (toGoal[source] >= 0) {
+        // The cheapest route follows the tree
+        Route *first = &routes[0];
+        first->length = 1;
+        for (u = source; u != destination; u = toward[u])
+            first->length++;
+        first->city = (int *)malloc(first->length * sizeof(int));
+        first->cost = (long long *)malloc(first->length * sizeof(long long));
+        first->deviation = 0;
+        int i = 0;
+        for (u = source; ; u = toward[u]) {
+            first->city[i] = u;
+            first->cost[i++] = toGoal[source] - toGoal[u];
+            if (u == destination)
+                break;
+        }
+        routeCount = 1;
+        found = 1;
+        printf("Yes Path Exists!\n");
+        printRoute(first, 1);
+    }
+
+    while (found == 1 && routeCount < count) {
+        Route *last = &routes[routeCount - 1];
+        int i, j;
+
+        // Leave the last route at each of its cities from where it left the route it was found from
+        for (i = last->deviation; i < last->length - 1 && found == 1; i++) {
+            int spur = last->city[i];
+            if (deadlinePassed()) {
+                found = -1;
+                break;
+            }
+            stamp++;
+            spurSearches++;
+
+            // The root up to the spur city is kept, and the routes found with the same root may not be repeated
+            for (j = 0; j <= i; j++)
+                blocked[last->city[j]] = stamp;
+            for (j = 0; j < routeCount; j++) {
+                if (routes[j].length > i + 1 && memcmp(routes[j].city, last->city, (i + 1) * sizeof(int)) == 0)
+                    banned[routes[j].city[i + 1]] = stamp;
+            }
+
+            int reached = -1;
+            heap.size = 0;
+            cost[spur] = 0;
+            parent[spur] = -1;
+            seen[spur] = stamp;
+            heapPush(&heap, toGoal[spur], spur, 0);
+            while (heapPop(&heap, &item)) {
+                int v = item.city;
+                if (done[v] == stamp)
+                    continue;
+                done[v] = stamp;
+                settledCount++;
+                if ((settledCount & 0xFFFF) == 0 && deadlinePassed()) {
+                    found = -1;
+                    break;
+                }
+
+                if (v != spur) {
+                    // The route in the tree finishes the search unless it meets the root
+                    int avoids = 1;
+                    for (u = v; u != destination; u = toward[u]) {
+                        if (clear[u] == stamp || clear[u] == -stamp) {
+                            avoids = clear[u] > 0;
+                            break;
+                        }
+                        if (blocked[u] == stamp) {
+                            avoids = 0;
+                            break;
+                        }
+                    }
+                    int stop = u;
+                    for (u = v; u != stop; u = toward[u])
+                        clear[u] = avoids ? stamp : -stamp;
+                    if (avoids) {
+                        reached = v;
+                        break;
+                    }
+                }
+
+                for (e = rowStart[v]; e < rowStart[v + 1]; e++) {
+                    int w = adjacency[e];
+                    if (toGoal[w] < 0 || blocked[w] == stamp || done[w] == stamp || (v == spur && banned[w] == stamp))
+                        continue;
+                    long long g = cost[v] + linkCost(weight, e);
+                    if (seen[w] != stamp || g < cost[w]) {
+                        seen[w] = stamp;
+                        cost[w] = g;
+                        parent[w] = v;
+                        heapPush(&heap, g + toGoal[w], w, 0);
+                    }
+                }
+            }
+            if (reached < 0)
+                continue;
+
+            // The root, then the spur search back from the city it reached, then the tree
+            Route candidate;
+            int spurLength = 0, treeLength = 0;
+            for (u = reached; u != spur; u = parent[u])
+                spurLength++;
+            for (u = reached; u != destination; u = toward[u])
+                treeLength++;
+            candidate.length = i + 1 + spurLength + treeLength;
+            candidate.city = (int *)malloc(candidate.length * sizeof(int));
+            candidate.cost = (long long *)malloc(candidate.length * sizeof(long long));
+            candidate.deviation = i;
+            memcpy(candidate.city, last->city, (i + 1) * sizeof(int));
+            memcpy(candidate.cost, last->cost, (i + 1) * sizeof(long long));
+            for (u = reached, j = i + spurLength; u != spur; u = parent[u], j--) {
+                candidate.city[j] = u;
+                candidate.cost[j] = last->cost[i] + cost[u];
+            }
+            long long base = last->cost[i] + cost[reached] + toGoal[reached];
+            for (u = toward[reached], j = i + spurLength + 1; j < candidate.length; u = toward[u], j++) {
+                candidate.city[j] = u;
+                candidate.cost[j] = base - toGoal[u];
+            }
+
+            int repeated = 0;
+            long c;
+            for (c = 0; c < candidateCount && !repeated; c++)
+                repeated = sameRoute(&candidate, &candidates[c]);
+            if (repeated) {
+                free(candidate.city);
+                free(candidate.cost);
+                continue;
+            }
+            if (candidateCount == candidateCapacity) {
+                candidateCapacity = candidateCapacity ? 2 * candidateCapacity : 16;
+                candidates = (Route *)realloc(candidates, candidateCapacity * sizeof(Route));
+            }
+            candidates[candidateCount++] = candidate;
+        }
+        if (found != 1 || candidateCount == 0)
+            break;
+
+        // The cheapest candidate is the next route, the one with fewer cities and then the smaller cities on a tie
+        long best = 0, c;
+        for (c = 1; c < candidateCount; c++) {
+            const Route *a = &candidates[c], *b = &candidates[best];
+            long long difference = a->cost[a->length - 1] - b->cost[b->length - 1];
+            if (difference == 0)
+                difference = a->length - b->length;
+            for (j = 0; difference == 0 && j < a->length; j++)
+                difference = a->city[j] - b->city[j];
+            if (difference < 0)
+                best = c;
+        }
+        routes[routeCount++] = candidates[best];
+        candidates[best] = candidates[--candidateCount];
+        printRoute(&routes[routeCount - 1], routeCount);
+    }
+
+    if (statsOutput)
+        fprintf(stderr, "Spur searches: %ld, settled cities: %ld\n", spurSearches, settledCount);
+
+    while (routeCount > 0) {
+        routeCount--;
+        free(routes[routeCount].city);
+        free(routes[routeCount].cost);
+    }
+    while (candidateCount > 0) {
+        candidateCount--;
+        free(candidates[candidateCount].city);
+        free(candidates[candidateCount].cost);
+    }
+    free(routes);
+    free(candidates);
+    free(heap.items);
+    free(toGoal);
+    free(toward);
+    free(cost);
+    free(parent);
+    free(seen);
+    free(done);
+    free(blocked);
+    free(banned);
+    free(clear);
+    return found;
+}
+
+void loadFailures(void) {
+    char token[32];
+    double chance;
+    int u, v;
+
+    if (survival != NULL)
+        return;
+    if (failuresFile == NULL) {
+        fprintf(stderr, "Error: No failure probabilities given! Use --failures <file>.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    FILE *file = fopen(failuresFile, "r");
+    if (file == NULL) {
+        fprintf(stderr, "Error opening the failures file %s\n", failuresFile);
+        exit(EXIT_FAILURE);
+    }
+
+    // Connections not listed never fail, unless a "*" line says otherwise
+    uint32_t *given = (uint32_t *)malloc((edgeCount + 1) * sizeof(uint32_t));
+    unsigned char *listed = (unsigned char *)calloc(edgeCount + 1, 1);
+    uint32_t rest = 1U << SURVIVAL_BITS;
+    long e;
+
+    while (fscanf(file, "%31s", token) == 1) {
+        int star = strcmp(token, "*") == 0;
+        if (!star && (sscanf(token, "%d", &u) != 1 || fscanf(file, "%d", &v) != 1)) {
+            fprintf(stderr, "Error: Invalid line in the failures file %s\n", failuresFile);
+            exit(EXIT_FAILURE);
+        }
+        if (fscanf(file, "%lf", &chance) != 1 || chance < 0 || chance > 1) {
+            fprintf(stderr, "Error: Invalid failure probability in the failures file %s\n", failuresFile);
+            exit(EXIT_FAILURE);
+        }
+
+        uint32_t works = (uint32_t)llround((1 - chance) * (1U << SURVIVAL_BITS));
+        if (star) {
+            rest = works;
+            continue;
+        }
+
+        // The neighbors of a city are sorted, so the connection is found by bisection
+        long low = u >= 0 && u < N ? rowStart[u] : 0, high = u >= 0 && u < N ? rowStart[u + 1] : 0;
+        while (low < high) {
+            long middle = low + (high - low) / 2;
+            if (adjacency[middle] < v)
+                low = middle + 1;
+            else
+                high = middle;
+        }
+        if (u < 0 || u >= N || low == rowStart[u + 1] || adjacency[low] != v) {
+            fprintf(stderr, "Error: The failures file lists the connection %d -> %d, which is not in the network.\n", u, v);
+            exit(EXIT_FAILURE);
+        }
+        given[low] = works;
+        listed[low] = 1;
+    }
+    fclose(file);
+
+    for (e = 0; e < edgeCount; e++)
+        given[e] = listed[e] ? given[e] : rest;
+    free(listed);
+    survival = given;
+}
+
+// Function to mix the bits of a number (the finalizer of splitmix64)
+uint64_t mixBits(uint64_t x) {
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+uint64_t sampleWorlds(long e, long batch) {
+    uint32_t chance = survival[e];
+    uint64_t worlds = 0;
+    int step;
+
+    if (chance >= 1U << SURVIVAL_BITS)
+        return ~0ULL;
+    if (chance == 0)
+        return 0;
+
+    uint64_t random = mixBits(mixBits((uint64_t)e + 1) + (uint64_t)batch) | 1;
+    for (step = lowestBit(chance); step < SURVIVAL_BITS; step++) {
+        random ^= random << 13;
+        random ^= random >> 7;
+        random ^= random << 17;
+        worlds = (chance >> step) & 1 ? worlds | random : worlds & random;
+    }
+    return worlds;
+}
+
+void *reliabilityThread(void *arg) {
+    ReliabilityJob *job = (ReliabilityJob *)arg;
+    uint64_t *reach = (uint64_t *)calloc((size_t)N + 1, sizeof(uint64_t)); // The worlds in which each city is reached
+    int *queue = (int *)malloc(((size_t)N + 1) * sizeof(int)); // The cities with worlds not passed on yet, in a ring
+    unsigned char *queued = (unsigned char *)calloc((size_t)N + 1, 1);
+    int *touched = (int *)malloc(((size_t)N + 1) * sizeof(int)); // The cities reached in the current batch
+    long batch, e, i;
+
+    for (batch = job->thread; batch < job->batches; batch += job->threads) {
+        long head = 0, tail = 0, touchedCount = 0;
+
+        if (deadlinePassed())
+            break;
+
+        reach[job->source] = ~0ULL;
+        touched[touchedCount++] = job->source;
+        queue[tail++] = job->source;
+        queued[job->source] = 1;
+
+        while (head != tail) {
+            int u = queue[head];
+            head = head == N ? 0 : head + 1;
+            queued[u] = 0;
+
+            uint64_t worlds = reach[u];
+            for (e = rowStart[u]; e < rowStart[u + 1]; e++) {
+                int w = adjacency[e];
+
+                // Only sample the connection when it could bring new worlds
+                uint64_t fresh = worlds & ~reach[w];
+                if (fresh == 0)
+                    continue;
+                if (job->worlds == NULL) {
+                    fresh &= sampleWorlds(e, batch);
+                    job->examined++;
+                }
+                else {
+                    // A connection met again in the batch reuses its worlds
+                    if (job->sampledIn[e] != (uint32_t)(batch + 1)) {
+                        job->sampledIn[e] = (uint32_t)(batch + 1);
+                        job->worlds[e] = sampleWorlds(e, batch);
+                        job->examined++;
+                    }
+                    fresh &= job->worlds[e];
+                }
+                if (fresh == 0)
+                    continue;
+
+                if (reach[w] == 0)
+                    touched[touchedCount++] = w;
+                reach[w] |= fresh;
+                if (!queued[w]) {
+                    queued[w] = 1;
+                    queue[tail] = w;
+                    tail = tail == N ? 0 : tail + 1;
+                }
+            }
+        }
+
+        for (i = 0; i < touchedCount; i++) {
+            job->reached[touched[i]] += countBits(reach[touched[i]]);
+            reach[touched[i]] = 0;
+        }
+        job->done++;
+    }
+
+    free(reach);
+    free(queue);
+    free(queued);
+    free(touched);
+    return NULL;
+}
+
+void implementReliability (char **filename, const char *list) {
+    loadGraph(*filename);
+    loadFailures();
+
+    int sourceCount, *sources = parseCityList(list, &sourceCount), i, k;
+    if (sources == NULL) {
+        fprintf(stderr, "Invalid sources: %s (use a list such as 0 or 0-99,120)\n", list);
+        exit(EXIT_FAILURE);
+    }
+
+    // The worlds are sampled 64 at a time
+    long batches = (sampleCount + 63) / 64;
+    long processors = sysconf(_SC_NPROCESSORS_ONLN);
+    int threads = processors > 0 ? (int)processors : 1;
+    if (threads > batches)
+        threads = (int)batches;
+
+    // Every thread caches the worlds of the connections if the memory allows
+    size_t budget = memLimit > 0 ? memLimit : physicalMemory() / 2;
+    size_t cache = (size_t)edgeCount * (sizeof(uint64_t) + sizeof(uint32_t));
+    size_t perThread = ((size_t)N + 1) * (2 * sizeof(uint64_t) + 2 * sizeof(int) + 1);
+    int cached = cache + perThread <= budget;
+    if (cached && (size_t)threads * (cache + perThread) > budget)
+        threads = (int)(budget / (cache + perThread));
+    checkMemory((size_t)threads * perThread, "The sampled worlds");
+
+    ReliabilityJob *job = (ReliabilityJob *)malloc(threads * sizeof(ReliabilityJob));
+    pthread_t *thread = (pthread_t *)malloc(threads * sizeof(pthread_t));
+    for (k = 0; k < threads; k++) {
+        job[k].reached = (long *)malloc(((size_t)N + 1) * sizeof(long));
+        job[k].worlds = cached ? (uint64_t *)malloc((edgeCount + 1) * sizeof(uint64_t)) : NULL;
+        job[k].sampledIn = cached ? (uint32_t *)calloc(edgeCount + 1, sizeof(uint32_t)) : NULL;
+    }
+
+    startDeadline();
+    printf("Reliability\n");
+    for (i = 0; i < sourceCount && !cancelled; i++) {
+        for (k = 0; k < threads; k++) {
+            job[k].source = sources[i];
+            job[k].batches = batches;
+            job[k].thread = k;
+            job[k].threads = threads;
+            memset(job[k].reached, 0, ((size_t)N + 1) * sizeof(long));
+            job[k].done = 0;
+            job[k].examined = 0;
+
+            if (pthread_create(&thread[k], NULL, reliabilityThread, &job[k]) != 0) {
+                fprintf(stderr, "Error: Unable to start the thread for the reliability.\n");
+                exit(EXIT_FAILURE);
+            }
+        }
+
+        long done = 0, examined = 0;
+        for (k = 0; k < threads; k++) {
+            pthread_join(thread[k], NULL);
+            done += job[k].done;
+            examined += job[k].examined;
+        }
+        if (done == 0)
+            break;
+
+        // The chance of each city is the share of the worlds it was reached in, for the cities reached at all
+        int city;
+        printf("From %d:", sources[i]);
+        for (city = 0; city < N; city++) {
+            long reached = 0;
+            for (k = 0; k < threads; k++)
+                reached += job[k].reached[city];
+            if (reached > 0)
+                printf(" %d=%.4f", city, (double)reached / (64.0 * done));
+        }
+        printf("\n");
+        if (statsOutput)
+            fprintf(stderr, "Source %d: %ld sampled worlds, %ld connections sampled\n", sources[i], 64 * done, examined);
+    }
+    reportDeadline("the sources not done yet are missing, and the last one has fewer samples");
+
+    for (k = 0; k < threads; k++) {
+        free(job[k].reached);
+        free(job[k].worlds);
+        free(job[k].sampledIn);
+    }
+    free(job);
+    free(thread);
+    free(sources);
+}
+
+void *pageRankThread(void *arg) {
+    PageRankJob *job = (PageRankJob *)arg;
+    int u, v, k, step = 0;
+    long e;
+
+    for (;;) {
+        const double *rank = job->rank[step & 1];
+        double *next = job->rank[(step + 1) & 1];
+
+        // Spread the rank of every city over its connections
+        double dangling = 0;
+        for (u = job->first; u < job->last; u++) {
+            long degree = rowStart[u + 1] - rowStart[u];
+            if (degree > 0)
+                job->share[u] = rank[u] / degree;
+            else {
+                job->share[u] = 0;
+                dangling += rank[u];
+            }
+        }
+        job->dangling[job->thread] = dangling;
+        pthread_barrier_wait(job->barrier);
+
+        // The rank of the cities without connections goes to every city
+        dangling = 0;
+        for (k = 0; k < job->threads; k++)
+            dangling += job->dangling[k];
+        double base = (1 - damping + damping * dangling) / N, change = 0;
+
+        // Pull the rank of every city from the cities connected into it
+        for (v = job->first; v < job->last; v++) {
+            double sum = 0;
+            for (e = job->inStart[v]; e < job->inStart[v + 1]; e++)
+                sum += job->share[job->inList[e]];
+            next[v] = base + damping * sum;
+            change += fabs(next[v] - rank[v]);
+        }
+        job->change[job->thread] = change;
+        pthread_barrier_wait(job->barrier);
+
+        if (job->thread == 0) {
+            change = 0;
+            for (k = 0; k < job->threads; k++)
+                change += job->change[k];
+            (*job->iterations)++;
+            *job->finished = change < PAGERANK_TOLERANCE || *job->iterations == PAGERANK_ITERATIONS || deadlinePassed();
+            job->change[0] = change;
+        }
+        pthread_barrier_wait(job->barrier);
+        step++;
+        if (*job->finished)
+            break;
+    }
+    return NULL;
+}
+
+void implementPageRank (char **filename) {
+    loadGraph(*filename);
+
+    long *inStart;
+    int *inList, *inWeight, k, u;
+    buildReverse(&inStart, &inList, &inWeight);
+    free(inWeight);
+
+    long processors = sysconf(_SC_NPROCESSORS_ONLN);
+    int threads = processors > 0 ? (int)processors : 1;
+    if (threads > N)
+        threads = N > 0 ? N : 1;
+
+    double *rank[2];
+    rank[0] = (double *)malloc(((size_t)N + 1) * sizeof(double));
+    rank[1] = (double *)malloc(((size_t)N + 1) * sizeof(double));
+    double *share = (double *)malloc(((size_t)N + 1) * sizeof(double));
+    double *dangling = (double *)malloc(threads * sizeof(double));
+    double *change = (double *)malloc(threads * sizeof(double));
+    for (u = 0; u < N; u++)
+        rank[0][u] = 1.0 / N;
+
+    PageRankJob *job = (PageRankJob *)malloc(threads * sizeof(PageRankJob));
+    pthread_t *thread = (pthread_t *)malloc(threads * sizeof(pthread_t));
+    pthread_barrier_t barrier;
+    int finished = 0, iterations = 0;
+    pthread_barrier_init(&barrier, NULL, threads);
+
+    // Every thread gets about the same number of cities plus connections into them
+    double total = (double)N + (double)edgeCount;
+    int first = 0;
+    startDeadline();
+    for (k = 0; k < threads; k++) {
+        int last = first;
+        while (last < N && (k == threads - 1 || (double)last + (double)inStart[last] < total * (k + 1) / threads))
+            last++;
+
+        job[k].first = first;
+        job[k].last = last;
+        job[k].thread = k;
+        job[k].threads = threads;
+        job[k].inStart = inStart;
+        job[k].inList = inList;
+        job[k].rank[0] = rank[0];
+        job[k].rank[1] = rank[1];
+        job[k].share = share;
+        job[k].dangling = dangling;
+        job[k].change = change;
+        job[k].barrier = &barrier;
+        job[k].finished = &finished;
+        job[k].iterations = &iterations;
+        first = last;
+    }
+    for (k = 0; k < threads; k++) {
+        if (pthread_create(&thread[k], NULL, pageRankThread, &job[k]) != 0) {
+            fprintf(stderr, "Error: Unable to start the thread for PageRank.\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    for (k = 0; k < threads; k++)
+        pthread_join(thread[k], NULL);
+
+    const double *result = rank[iterations & 1];
+    printf("PageRank\n");
+    for (u = 0; u < N; u++)
+        printf("%d: %.8f\n", u, result[u]);
+    if (statsOutput)
+        fprintf(stderr, "PageRank: %d iterations, last change %g\n", iterations, change[0]);
+    reportDeadline("the ranks have not converged");
+
+    pthread_barrier_destroy(&barrier);
+    free(job);
+    free(thread);
+    free(rank[0]);
+    free(rank[1]);
+    free(share);
+    free(dangling);
+    free(change);
+    free(inStart);
+    free(inList);
+}
+
+void buildFlowNetwork(FlowNetwork *flow) {
+    long e, *position;
+    int u;
+
+    // Every connection u -> v is an arc of u and a backward arc of v
+    flow->arcStart = (long *)calloc((size_t)N + 2, sizeof(long));
+    for (u = 0; u < N; u++) {
+        for (e = rowStart[u]; e < rowStart[u + 1]; e++) {
+            flow->arcStart[u + 1]++;
+            flow->arcStart[adjacency[e] + 1]++;
+        }
+    }
+    for (u = 0; u < N; u++)
+        flow->arcStart[u + 1] += flow->arcStart[u];
+
+    long arcs = 2 * edgeCount + 1;
+    flow->arcTo = (int *)malloc(arcs * sizeof(int));
+    flow->arcPair = (long *)malloc(arcs * sizeof(long));
+    flow->arcEdge = (long *)malloc(arcs * sizeof(long));
+    flow->residual = (long long *)malloc(arcs * sizeof(long long));
+    position = (long *)malloc(((size_t)N + 1) * sizeof(long));
+    memcpy(position, flow->arcStart, ((size_t)N + 1) * sizeof(long));
+
+    for (u = 0; u < N; u++) {
+        for (e = rowStart[u]; e < rowStart[u + 1]; e++) {
+            int v = adjacency[e];
+            long forward = position[u]++, backward = position[v]++;
+            flow->arcTo[forward] = v;
+            flow->arcPair[forward] = backward;
+            flow->arcEdge[forward] = e;
+            flow->arcTo[backward] = u;
+            flow->arcPair[backward] = forward;
+            flow->arcEdge[backward] = -1;
+        }
+    }
+    free(position);
+}
+
+void globalRelabel(const FlowNetwork *flow, int sink, int *height, int *queue) {
+    long head = 0, tail = 0, a;
+    int u;
+
+    for (u = 0; u < N; u++)
+        height[u] = N;
+    height[sink] = 0;
+    queue[tail++] = sink;
+    while (head < tail) {
+        int v = queue[head++];
+        for (a = flow->arcStart[v]; a < flow->arcStart[v + 1]; a++) {
+            // The arc back into v has capacity left
+            int w = flow->arcTo[a];
+            if (height[w] == N && flow->residual[flow->arcPair[a]] > 0) {
+                height[w] = height[v] + 1;
+                queue[tail++] = w;
+            }
+        }
+    }
+}
+
+// Function to add a city to the list of its height
+void addToHeight(HeightBuckets *buckets, int city, int height) {
+    buckets->previous[city] = -1;
+    buckets->next[city] = buckets->first[height];
+    if (buckets->first[height] >= 0)
+        buckets->previous[buckets->first[height]] = city;
+    buckets->first[height] = city;
+    if (height > buckets->highest)
+        buckets->highest = height;
+}
+
+// Function to take a city out of the list of its height
+void removeFromHeight(HeightBuckets *buckets, int city, int height) {
+    if (buckets->previous[city] >= 0)
+        buckets->next[buckets->previous[city]] = buckets->next[city];
+    else
+        buckets->first[height] = buckets->next[city];
+    if (buckets->next[city] >= 0)
+        buckets->previous[buckets->next[city]] = buckets->previous[city];
+}
+
+long long pushRelabel(FlowNetwork *flow, int source, int sink, int unit) {
+    int *height = (int *)malloc(((size_t)N + 1) * sizeof(int));
+    HeightBuckets buckets;
+    buckets.first = (int *)malloc(((size_t)N + 1) * sizeof(int));
+    buckets.next = (int *)malloc(((size_t)N + 1) * sizeof(int));
+    buckets.previous = (int *)malloc(((size_t)N + 1) * sizeof(int));
+    int *queue = (int *)malloc(((size_t)N + 1) * sizeof(int)); // The active cities, in a ring
+    int *search = (int *)malloc(((size_t)N + 1) * sizeof(int)); // The queue of the global relabeling
+    unsigned char *active = (unsigned char *)calloc((size_t)N + 1, 1);
+    long long *excess = (long long *)calloc((size_t)N + 1, sizeof(long long));
+    long *current = (long *)malloc(((size_t)N + 1) * sizeof(long)); // The next arc to push along of every city
+    long head = 0, tail = 0, a, relabels = N, steps = 0; // Starts with a global relabeling
+    int u, v, h, stopped = 0;
+
+    if (height == NULL || buckets.first == NULL || buckets.next == NULL || buckets.previous == NULL) {
+        fprintf(stderr, "Error: Not enough memory for the maximum flow.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    for (a = 0; a < flow->arcStart[N]; a++)
+        flow->residual[a] = flow->arcEdge[a] < 0 ? 0 : (unit ? 1 : linkCost(weight, flow->arcEdge[a]));
+
+    // Fill every connection out of the source
+    for (a = flow->arcStart[source]; a < flow->arcStart[source + 1]; a++) {
+        long long amount = flow->residual[a];
+        v = flow->arcTo[a];
+        if (amount <= 0 || v == source)
+            continue;
+        flow->residual[a] = 0;
+        flow->residual[flow->arcPair[a]] += amount;
+        excess[v] += amount;
+        if (v != sink && !active[v]) {
+            active[v] = 1;
+            queue[tail] = v;
+            tail = tail == N ? 0 : tail + 1;
+        }
+    }
+
+    while (head != tail) {
+        // Relabel all the cities at once every N relabels
+        if (relabels >= N) {
+            globalRelabel(flow, sink, height, search);
+            height[source] = N;
+            memset(buckets.first, 0xFF, ((size_t)N + 1) * sizeof(int));
+            buckets.highest = -1;
+            for (v = 0; v < N; v++) {
+                if (height[v] < N)
+                    addToHeight(&buckets, v, height[v]);
+                current[v] = flow->arcStart[v];
+            }
+            relabels = 0;
+        }
+
+        u = queue[head];
+        head = head == N ? 0 : head + 1;
+        active[u] = 0;
+        if ((++steps & 0xFFFF) == 0 && deadlinePassed()) {
+            stopped = 1;
+            break;
+        }
+
+        // Push the excess down along the arcs with capacity left, relabeling when they run out
+        while (excess[u] > 0 && height[u] < N) {
+            if (current[u] == flow->arcStart[u + 1]) {
+                int old = height[u], lowest = 2 * N;
+                for (a = flow->arcStart[u]; a < flow->arcStart[u + 1]; a++) {
+                    if (flow->residual[a] > 0 && height[flow->arcTo[a]] < lowest)
+                        lowest = height[flow->arcTo[a]];
+                }
+                height[u] = lowest + 1 < N ? lowest + 1 : N;
+                current[u] = flow->arcStart[u];
+                relabels++;
+                removeFromHeight(&buckets, u, old);
+                if (height[u] < N)
+                    addToHeight(&buckets, u, height[u]);
+
+                // Gap: the cities above an empty height cannot reach the sink
+                if (buckets.first[old] < 0) {
+                    for (h = old + 1; h <= buckets.highest; h++) {
+                        for (v = buckets.first[h]; v >= 0; v = buckets.next[v])
+                            height[v] = N;
+                        buckets.first[h] = -1;
+                    }
+                    buckets.highest = old - 1;
+                }
+                continue;
+            }
+
+            a = current[u];
+            v = flow->arcTo[a];
+            if (flow->residual[a] > 0 && height[u] == height[v] + 1) {
+                long long amount = excess[u] < flow->residual[a] ? excess[u] : flow->residual[a];
+                flow->residual[a] -= amount;
+                flow->residual[flow->arcPair[a]] += amount;
+                excess[u] -= amount;
+                excess[v] += amount;
+                if (v != sink && v != source && !active[v]) {
+                    active[v] = 1;
+                    queue[tail] = v;
+                    tail = tail == N ? 0 : tail + 1;
+                }
+            }
+            if (excess[u] > 0)
+                current[u]++;
+        }
+    }
+
+    long long value = stopped ? -1 : excess[sink];
+    free(height);
+    free(buckets.first);
+    free(buckets.next);
+    free(buckets.previous);
+    free(queue);
+    free(search);
+    free(active);
+    free(excess);
+    free(current);
+    return value;
+}
+
+void implementMaxflow (char **filename) {
+    int source = -1, sink = -1;
+    long e;
+
+    if (sscanf(optarg, "%d,%d", &source, &sink) != 2) {
+        fprintf(stderr, "Invalid source and sink cities: %s\n", optarg);
+        exit(EXIT_FAILURE);
+    }
+    loadGraph(*filename);
+    if (source < 0 || source >= N || sink < 0 || sink >= N || source == sink) {
+        fprintf(stderr, "Invalid source and sink cities: %s\n", optarg);
+        exit(EXIT_FAILURE);
+    }
+    for (e = 0; e < edgeCount; e++) {
+        if (linkCost(weight, e) < 0) {
+            fprintf(stderr, "Error: A connection has a negative capacity.\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    FlowNetwork flow;
+    buildFlowNetwork(&flow);
+    startDeadline();
+
+    long long value = pushRelabel(&flow, source, sink, 0);
+    if (value < 0) {
+        reportDeadline("the maximum flow was not found");
+    }
+    else {
+        // The cut separates the cities that can still reach the sink from the others
+        int *height = (int *)malloc(((size_t)N + 1) * sizeof(int));
+        int *search = (int *)malloc(((size_t)N + 1) * sizeof(int));
+        int u;
+        long links = 0;
+        globalRelabel(&flow, sink, height, search);
+
+        for (u = 0; u < N; u++) {
+            for (e = rowStart[u]; e < rowStart[u + 1]; e++) {
+                if (height[u] == N && height[adjacency[e]] < N && linkCost(weight, e) > 0)
+                    links++;
+            }
+        }
+        printf("Maximum flow: %lld\n", value);
+        printf("Minimum cut: %ld links\n", links);
+        for (u = 0; u < N; u++) {
+            for (e = rowStart[u]; e < rowStart[u + 1]; e++) {
+                if (height[u] == N && height[adjacency[e]] < N && linkCost(weight, e) > 0)
+                    printf("%d=>%d %d\n", u, adjacency[e], linkCost(weight, e));
+            }
+        }
+        free(height);
+        free(search);
+
+        // Routes without a common connection: the flow with capacities 1 (Menger)
+        long long routes = weight == NULL || hopsOnly ? value : pushRelabel(&flow, source, sink, 1);
+        if (routes < 0)
+            reportDeadline("the number of routes without a common connection was not found");
+        else
+            printf("Edge-disjoint routes: %lld\n", routes);
+    }
+
+    free(flow.arcStart);
+    free(flow.arcTo);
+    free(flow.arcPair);
+    free(flow.arcEdge);
+    free(flow.residual);
+}
+
+void *cycleBitsThread(void *arg) {
+    CycleJob *job = (CycleJob *)arg;
+    uint64_t *seen = (uint64_t *)calloc((size_t)N + 1, sizeof(uint64_t)); // The sources that reached each city
+    uint64_t *frontier = (uint64_t *)calloc((size_t)N + 1, sizeof(uint64_t)); // The sources that reached it in the last level
+    uint64_t *next = (uint64_t *)calloc((size_t)N + 1, sizeof(uint64_t)); // The sources reaching it in this level
+    int *list = (int *)malloc(((size_t)N + 1) * sizeof(int)); // The cities of the frontier
+    int *nextList = (int *)malloc(((size_t)N + 1) * sizeof(int)); // The cities with bits in next
+    int *touched = (int *)malloc(((size_t)N + 1) * sizeof(int)); // The cities with bits in seen
+    long batch, e;
+
+    for (batch = job->thread; batch * 64 < N; batch += job->threads) {
+        int first = (int)(batch * 64), count = N - first < 64 ? N - first : 64, i, level = 0;
+        long listCount = 0, touchedCount = 0, k;
+        uint64_t alive = count == 64 ? ~0ULL : (1ULL << count) - 1; // The sources still without a cycle
+
+        if (deadlinePassed())
+            break;
+
+        for (i = 0; i < count; i++) {
+            seen[first + i] = frontier[first + i] = 1ULL << i;
+            list[listCount++] = first + i;
+            touched[touchedCount++] = first + i;
+        }
+
+        while (listCount > 0 && alive != 0) {
+            long nextCount = 0;
+            level++;
+
+            for (k = 0; k < listCount; k++) {
+                int v = list[k];
+                uint64_t bits = frontier[v] & alive;
+                frontier[v] = 0;
+                if (bits == 0)
+                    continue;
+                for (e = rowStart[v]; e < rowStart[v + 1]; e++) {
+                    int w = adjacency[e];
+                    if (next[w] == 0)
+                        nextList[nextCount++] = w;
+                    next[w] |= bits;
+                }
+            }
+
+            // A source reached again closes its cycle
+            uint64_t returned = 0;
+            for (i = 0; i < count; i++)
+                returned |= next[first + i] & (1ULL << i) & alive;
+            while (returned != 0) {
+                i = lowestBit(returned);
+                job->cycle[first + i] = level;
+                returned &= returned - 1;
+                alive &= ~(1ULL << i);
+            }
+
+            listCount = 0;
+            for (k = 0; k < nextCount; k++) {
+                int w = nextList[k];
+                uint64_t fresh = next[w] & ~seen[w] & alive;
+                next[w] = 0;
+                if (fresh == 0)
+                    continue;
+                if (seen[w] == 0)
+                    touched[touchedCount++] = w;
+                seen[w] |= fresh;
+                frontier[w] = fresh;
+                list[listCount++] = w;
+            }
+        }
+
+        for (i = 0; i < count; i++) {
+            if (alive & (1ULL << i))
+                job->cycle[first + i] = -1;
+        }
+        for (k = 0; k < touchedCount; k++)
+            seen[touched[k]] = 0;
+        for (k = 0; k < listCount; k++)
+            frontier[list[k]] = 0;
+    }
+
+    free(seen);
+    free(frontier);
+    free(next);
+    free(list);
+    free(nextList);
+    free(touched);
+    return NULL;
+}
+
+void *cycleCostThread(void *arg) {
+    CycleJob *job = (CycleJob *)arg;
+    long long *distance = (long long *)malloc(((size_t)N + 1) * sizeof(long long));
+    int *reached = (int *)calloc((size_t)N + 1, sizeof(int)); // The search (plus one) that reached each city last
+    Heap heap = {NULL, 0, 0};
+    HeapItem item;
+    int source;
+    long e;
+
+    for (source = job->thread; source < N; source += job->threads) {
+        long long best = -1;
+
+        if (deadlinePassed())
+            break;
+
+        heap.size = 0;
+        distance[source] = 0;
+        reached[source] = source + 1;
+        heapPush(&heap, 0, source, 0);
+        while (heapPop(&heap, &item)) {
+            int v = item.city;
+            if (item.distance > distance[v])
+                continue;
+            if (best >= 0 && item.distance >= best)
+                break;
+
+            for (e = rowStart[v]; e < rowStart[v + 1]; e++) {
+                int w = adjacency[e];
+                long long d = item.distance + linkCost(weight, e);
+                if (w == source) {
+                    if (best < 0 || d < best)
+                        best = d;
+                }
+                else if (reached[w] != source + 1 || d < distance[w]) {
+                    reached[w] = source + 1;
+                    distance[w] = d;
+                    heapPush(&heap, d, w, 0);
+                }
+            }
+        }
+        job->cycle[source] = best;
+    }
+
+    free(heap.items);
+    free(distance);
+    free(reached);
+    return NULL;
+}
+
+void implementCycles (char **filename) {
+    loadGraph(*filename);
+
+    int costs = weight != NULL && !hopsOnly, k, u;
+    long e;
+    if (costs) {
+        for (e = 0; e < edgeCount; e++) {
+            if (weight[e] < 0) {
+                fprintf(stderr, "Error: A connection has a negative cost.\n");
+                exit(EXIT_FAILURE);
+            }
+        }
+    }
+
+    long processors = sysconf(_SC_NPROCESSORS_ONLN);
+    int threads = processors > 0 ? (int)processors : 1;
+    long long *cycle = (long long *)malloc(((size_t)N + 1) * sizeof(long long));
+    for (u = 0; u < N; u++)
+        cycle[u] = -2;
+
+    CycleJob *job = (CycleJob *)malloc(threads * sizeof(CycleJob));
+    pthread_t *thread = (pthread_t *)malloc(threads * sizeof(pthread_t));
+    startDeadline();
+    for (k = 0; k < threads; k++) {
+        job[k].thread = k;
+        job[k].threads = threads;
+        job[k].cycle = cycle;
+        if (pthread_create(&thread[k], NULL, costs ? cycleCostThread : cycleBitsThread, &job[k]) != 0) {
+            fprintf(stderr, "Error: Unable to start the thread for the cycles.\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    for (k = 0; k < threads; k++)
+        pthread_join(thread[k], NULL);
+
+    long long girth = -1;
+    printf("Shortest cycles\n");
+    for (u = 0; u < N; u++) {
+        if (cycle[u] == -2)
+            continue;
+        if (cycle[u] < 0)
+            printf("%d: none\n", u);
+        else
+            printf("%d: %lld\n", u, cycle[u]);
+        if (cycle[u] >= 0 && (girth < 0 || cycle[u] < girth))
+            girth = cycle[u];
+    }
+    if (girth < 0)
+        printf("Girth: none\n");
+    else
+        printf("Girth: %lld\n", girth);
+    reportDeadline("the cities not searched yet are missing, and the girth is of the others");
+
+    free(cycle);
+    free(job);
+    free(thread);
+}
+
+void buildChains(void) {
+    int u, x, c;
+    long e;
+
+    if (cityComponent != NULL)
+        return;
+
+    cityComponent = (int *)malloc(((size_t)N + 1) * sizeof(int));
+    componentCount = findComponents(cityComponent);
+    int count = componentCount;
+
+    // The cities of every component in ascending order, and whether they form a cycle
+    componentStart = (int *)calloc((size_t)count + 2, sizeof(int));
+    componentCities = (int *)malloc(((size_t)N + 1) * sizeof(int));
+    componentCycle = (unsigned char *)calloc((size_t)count + 1, 1);
+    for (u = 0; u < N; u++)
+        componentStart[cityComponent[u] + 1]++;
+    for (x = 0; x < count; x++) {
+        componentCycle[x] = componentStart[x + 1] > 1;
+        componentStart[x + 1] += componentStart[x];
+    }
+    int *position = (int *)malloc(((size_t)count + 1) * sizeof(int));
+    memcpy(position, componentStart, ((size_t)count + 1) * sizeof(int));
+    for (u = 0; u < N; u++) {
+        componentCities[position[cityComponent[u]]++] = u;
+        for (e = rowStart[u]; e < rowStart[u + 1]; e++) {
+            if (adjacency[e] == u)
+                componentCycle[cityComponent[u]] = 1;
+        }
+    }
+    free(position);
+
+    // The connections between the components, as adjacency lists of the condensed network
+    long *linkStart = (long *)calloc((size_t)count + 2, sizeof(long));
+    for (u = 0; u < N; u++) {
+        for (e = rowStart[u]; e < rowStart[u + 1]; e++) {
+            if (cityComponent[adjacency[e]] != cityComponent[u])
+                linkStart[cityComponent[u] + 1]++;
+        }
+    }
+    for (x = 0; x < count; x++)
+        linkStart[x + 1] += linkStart[x];
+    int *link = (int *)malloc((linkStart[count] + 1) * sizeof(int));
+    long *next = (long *)malloc(((size_t)count + 1) * sizeof(long));
+    memcpy(next, linkStart, ((size_t)count + 1) * sizeof(long));
+    for (u = 0; u < N; u++) {
+        for (e = rowStart[u]; e < rowStart[u + 1]; e++) {
+            if (cityComponent[adjacency[e]] != cityComponent[u])
+                link[next[cityComponent[u]]++] = cityComponent[adjacency[e]];
+        }
+    }
+
+    // Hopcroft-Karp: match every component to the next one on its path
+    int *matchNext = (int *)malloc(((size_t)count + 1) * sizeof(int)); // The next component on the path, -1 for none
+    int *matchPrevious = (int *)malloc(((size_t)count + 1) * sizeof(int)); // The previous component, -1 for none
+    int *layer = (int *)malloc(((size_t)count + 1) * sizeof(int)); // The layer of the search, -1 when not reached
+    int *queue = (int *)malloc(((size_t)count + 1) * sizeof(int));
+    int *stack = (int *)malloc(((size_t)count + 1) * sizeof(int)); // The components of the augmenting path
+    int *stackVia = (int *)malloc(((size_t)count + 1) * sizeof(int)); // The component each of them is matched to
+    for (x = 0; x < count; x++)
+        matchNext[x] = matchPrevious[x] = -1;
+
+    for (;;) {
+        // Layers of alternating paths from the unmatched components
+        int head = 0, tail = 0, open = 0;
+        for (x = 0; x < count; x++) {
+            layer[x] = matchNext[x] < 0 ? 0 : -1;
+            if (matchNext[x] < 0)
+                queue[tail++] = x;
+        }
+        while (head < tail) {
+            x = queue[head++];
+            for (e = linkStart[x]; e < linkStart[x + 1]; e++) {
+                int z = matchPrevious[link[e]];
+                if (z < 0)
+                    open = 1;
+                else if (layer[z] < 0) {
+                    layer[z] = layer[x] + 1;
+                    queue[tail++] = z;
+                }
+            }
+        }
+        if (!open)
+            break;
+
+        // Augment along disjoint shortest paths, with an explicit stack
+        memcpy(next, linkStart, ((size_t)count + 1) * sizeof(long));
+        for (x = 0; x < count; x++) {
+            int depth = 0;
+            if (matchNext[x] >= 0)
+                continue;
+            stack[0] = x;
+            while (depth >= 0) {
+                int v = stack[depth];
+                if (next[v] == linkStart[v + 1]) {
+                    layer[v] = -1;
+                    depth--;
+                    continue;
+                }
+                int y = link[next[v]++], z = matchPrevious[y];
+                if (z < 0) {
+                    stackVia[depth] = y;
+                    for (; depth >= 0; depth--) {
+                        matchNext[stack[depth]] = stackVia[depth];
+                        matchPrevious[stackVia[depth]] = stack[depth];
+                    }
+                    break;
+                }
+                if (layer[z] == layer[v] + 1) {
+                    stackVia[depth] = y;
+                    stack[++depth] = z;
+                }
+            }
+        }
+    }
+
+    // Every path starts at a component without a previous one
+    chainCount = 0;
+    chainStart = (int *)malloc(((size_t)count + 2) * sizeof(int));
+    chainComponents = (int *)malloc(((size_t)count + 1) * sizeof(int));
+    chainOf = (int *)malloc(((size_t)count + 1) * sizeof(int));
+    chainPosition = (int *)malloc(((size_t)count + 1) * sizeof(int));
+    int placed = 0;
+    for (x = 0; x < count; x++) {
+        if (matchPrevious[x] >= 0)
+            continue;
+        chainStart[chainCount] = placed;
+        for (c = x; c >= 0; c = matchNext[c]) {
+            chainOf[c] = chainCount;
+            chainPosition[c] = placed - chainStart[chainCount];
+            chainComponents[placed++] = c;
+        }
+        chainCount++;
+    }
+    chainStart[chainCount] = placed;
+
+    free(linkStart);
+    free(link);
+    free(next);
+    free(matchNext);
+    free(matchPrevious);
+    free(layer);
+    free(queue);
+    free(stack);
+    free(stackVia);
+}
+
+void buildChainLabels(void) {
+    int x, c, u;
+    long e;
+
+    if (chainLabels != NULL)
+        return;
+
+    chainLabels = (int *)malloc(((size_t)componentCount * chainCount + 1) * sizeof(int));
+    for (x = 0; x < componentCount; x++) {
+        int *label = chainLabels + (size_t)x * chainCount;
+        for (c = 0; c < chainCount; c++)
+            label[c] = INT_MAX;
+
+        // The components connected to have smaller numbers, so their labels are done
+        for (u = componentStart[x]; u < componentStart[x + 1]; u++) {
+            int city = componentCities[u];
+            for (e = rowStart[city]; e < rowStart[city + 1]; e++) {
+                int y = cityComponent[adjacency[e]];
+                if (y == x)
+                    continue;
+                const int *reached = chainLabels + (size_t)y * chainCount;
+                for (c = 0; c < chainCount; c++) {
+                    if (reached[c] < label[c])
+                        label[c] = reached[c];
+                }
+                if (chainPosition[y] < label[chainOf[y]])
+                    label[chainOf[y]] = chainPosition[y];
+            }
+        }
+    }
+}
+
+long closeRowsChains(int first, int last, PairFunction emit, void *context) {
+    size_t words = ((size_t)N + 63) / 64, k;
+    uint64_t *row = (uint64_t *)calloc(words + 1, sizeof(uint64_t)); // The cities reached from the source
+    long pairs = 0, e;
+    int u, c, i, p;
+
+    for (u = first; u < last && !deadlinePassed(); u++) {
+        int x = cityComponent[u];
+        const int *label = chainLabels + (size_t)x * chainCount;
+        long rowPairs = pairs;
+
+        // The other cities of a cycle, and the city itself only through a direct connection
+        if (componentCycle[x]) {
+            for (i = componentStart[x]; i < componentStart[x + 1]; i++) {
+                int w = componentCities[i];
+                row[w / 64] |= (uint64_t)1 << (w % 64);
+            }
+        }
+        row[u / 64] &= ~((uint64_t)1 << (u % 64));
+        for (e = rowStart[u]; e < rowStart[u + 1]; e++) {
+            if (adjacency[e] == u)
+                row[u / 64] |= (uint64_t)1 << (u % 64);
+        }
+
+        // Every chain from the earliest position reached to its end
+        for (c = 0; c < chainCount; c++) {
+            if (label[c] == INT_MAX)
+                continue;
+            for (p = chainStart[c] + label[c]; p < chainStart[c + 1]; p++) {
+                int y = chainComponents[p];
+                for (i = componentStart[y]; i < componentStart[y + 1]; i++) {
+                    int w = componentCities[i];
+                    row[w / 64] |= (uint64_t)1 << (w % 64);
+                }
+            }
+        }
+
+        for (k = 0; k < words; k++) {
+            while (row[k] != 0) {
+                emit(context, u, (int)(k * 64) + lowestBit(row[k]), 0);
+                pairs++;
+                row[k] &= row[k] - 1;
+            }
+        }
+
+        PROGRESS_ADD(progressPairs, pairs - rowPairs);
+        PROGRESS_ADD(progressRows, 1);
+    }
+
+    free(row);
+    return pairs;
+}
+
+void *routesThread(void *arg) {
+    RoutesJob *job = (RoutesJob *)arg;
+    int *seen = (int *)malloc(((size_t)N + 1) * sizeof(int)); // The last source that reached each city
+    long *hop = (long *)malloc(((size_t)N + 1) * sizeof(long)); // The first hop of the route to each city
+    int *queue = (int *)malloc(((size_t)N + 1) * sizeof(int));
+    int source, i, b;
+    long e;
+
+    for (i = 0; i < N; i++)
+        seen[i] = -1;
+
+    for (source = job->thread; source < N; source += job->threads) {
+        unsigned char *row = routeTable + (size_t)source * N * routeWidth;
+        int head = 0, tail = 0;
+
+        if (deadlinePassed())
+            break;
+
+        // The neighbors are their own first hops
+        seen[source] = source;
+        for (e = rowStart[source]; e < rowStart[source + 1]; e++) {
+            int w = adjacency[e];
+            if (seen[w] != source) {
+                seen[w] = source;
+                hop[w] = e - rowStart[source];
+                queue[tail++] = w;
+            }
+        }
+        while (head < tail) {
+            int v = queue[head++];
+            for (e = rowStart[v]; e < rowStart[v + 1]; e++) {
+                int w = adjacency[e];
+                if (seen[w] != source) {
+                    seen[w] = source;
+                    hop[w] = hop[v];
+                    queue[tail++] = w;
+                }
+            }
+        }
 
-/**
- * @brief Implements the "-i" option given by the user by opening the input file and reading 
- * the adjacency matrix, then printing the adjacency matrix to the console.
- * 
- * @param filename A pointer to the filename string.
- */
-void implementI (char **filename);
+        // The entries are little endian
+        for (i = 0; i < tail; i++) {
+            unsigned char *entry = row + (size_t)queue[i] * routeWidth;
+            for (b = 0; b < routeWidth; b++)
+                entry[b] = (unsigned char)(hop[queue[i]] >> (8 * b));
+        }
+    }
 
-/**
- * @brief Implements the "-r" option by finding a path between two cities and 
- * printing the path if it exists. It uses recursion by calling the findPath 
- * function which calls itself whenever needed to calculate the path.
- * 
- * @param filename A pointer to the filename string.
-*/
-void implementR (char **filename);
+    free(seen);
+    free(hop);
+    free(queue);
+    return NULL;
+}
 
-/**
- * @brief Implements the "-p" option by calculating the transitive closure of 
- * the cityMatrix and printing it to the console, using the calculateTransitiveClosure
- * function.
- * @param filename A pointer to the filename string.
-*/
-void implementP (char **filename);
+long routeHop(int source, int destination) {
+    const unsigned char *entry = routeTable + ((size_t)source * N + destination) * routeWidth;
+    unsigned long value = 0, none = 0;
+    int b;
 
-/**
- * @brief Implements the "-o" option by creating an output file, calculating the 
- * transitive closure, and then printing it to the file.
- * @param filename A pointer to the filename string.
-*/
-void implementO (char **filename);
+    for (b = 0; b < routeWidth; b++) {
+        value |= (unsigned long)entry[b] << (8 * b);
+        none |= 0xFFUL << (8 * b);
+    }
+    return value == none ? -1 : (long)value;
+}
 
-int N; // The number of cities
-int **cityMatrix; // The adjacency matrix
+int followRoute(int source, int destination) {
+    int city = source, steps;
 
-int main (int argc, char *argv[]){
+    // The whole route is checked before printing; no route has more than N - 1 hops
+    for (steps = 0; city != destination; steps++) {
+        long hop = routeHop(city, destination);
+        if (hop < 0 || steps >= N)
+            return findPath(source, destination);
+        city = adjacency[rowStart[city] + hop];
+    }
 
-    run(argc, argv);
-    return 0;
+    printf("Yes Path Exists!\n");
+    printf("%d", source);
+    for (city = source; city != destination; ) {
+        city = adjacency[rowStart[city] + routeHop(city, destination)];
+        printf("=>%d", city);
+    }
+    printf("\n");
+    return 1;
 }
 
- void run (int argc, char *argv[]){
+void implementRoutes (char **filename, const char *list) {
+    loadGraph(*filename);
 
-    int option;
-    char *filename = NULL;
+    int count = 0, *cities = NULL, k, u;
+    if (list != NULL && (cities = parseCityList(list, &count)) == NULL) {
+        fprintf(stderr, "Invalid cities: %s (use a list such as 0 or 0-99,120)\n", list);
+        exit(EXIT_FAILURE);
+    }
 
-    if (argc == 1) {
-        fprintf(stderr, "No command line arguments given!\n");
-        fprintf(stderr, "Usage: %s -i <filename> -r <source_city>,<destination_city> -p -o <output_file>\n", argv[0]);
+    // The entries are as wide as the largest position among the neighbors of a city, all ones for none
+    long most = 0;
+    for (u = 0; u < N; u++) {
+        if (rowStart[u + 1] - rowStart[u] > most)
+            most = rowStart[u + 1] - rowStart[u];
+    }
+    routeWidth = most < 0xFF ? 1 : (most < 0xFFFF ? 2 : 4);
+
+    size_t bytes = (size_t)N * N * routeWidth;
+    checkMemory(bytes, "The routing table");
+    free(routeTable);
+    routeTable = (unsigned char *)malloc(bytes + 1);
+    if (routeTable == NULL) {
+        fprintf(stderr, "Error: Not enough memory for the routing table (%zu bytes).\n", bytes);
         exit(EXIT_FAILURE);
     }
+    memset(routeTable, 0xFF, bytes);
 
-    while ((option = getopt(argc, argv, "i:r:po")) != -1) {
-        switch (option) {
-            case 'i':
-                implementI(&filename);
-                break;
-            case 'r':
-                implementR(&filename);
-                break;
-            case 'p':
-                implementP(&filename);
-                break;
-            case 'o':
-                implementO(&filename);
-                break;
-            case '?':
-                fprintf(stderr, "Usage: %s -i <inputfile> [-r <source>,<destination> -p -o]\n", argv[0]);
-                exit(EXIT_FAILURE);
+    long processors = sysconf(_SC_NPROCESSORS_ONLN);
+    int threads = processors > 0 ? (int)processors : 1;
+    RoutesJob *job = (RoutesJob *)malloc(threads * sizeof(RoutesJob));
+    pthread_t *thread = (pthread_t *)malloc(threads * sizeof(pthread_t));
+    startDeadline();
+    for (k = 0; k < threads; k++) {
+        job[k].thread = k;
+        job[k].threads = threads;
+        if (pthread_create(&thread[k], NULL, routesThread, &job[k]) != 0) {
+            fprintf(stderr, "Error: Unable to start the thread for the routing table.\n");
+            exit(EXIT_FAILURE);
         }
     }
+    for (k = 0; k < threads; k++)
+        pthread_join(thread[k], NULL);
 
-
-    // Check if the -i option was provided
-    if (filename == NULL) {
-        fprintf(stderr, "No input file given!\n");
-        fprintf(stderr, "Usage: %s -i <filename> [-r <source_city>,<destination_city> -p -o <output_file]\n", argv[0]);
+    // "CLRT", the number of cities and the bytes of an entry, then the rows, little endian
+    char *name = outputName(*filename, ".routes");
+    FILE *file = fopen(name, "wb");
+    unsigned char header[12];
+    if (file == NULL) {
+        fprintf(stderr, "Error opening the output file \n");
         exit(EXIT_FAILURE);
     }
+    memcpy(header, "CLRT", 4);
+    writeLE32(header + 4, N);
+    writeLE32(header + 8, routeWidth);
+    fwrite(header, 1, 12, file);
+    fwrite(routeTable, 1, bytes, file);
+    fclose(file);
+    printf("Saving %s...\n", name);
+    free(name);
+
+    for (k = 0; k < count; k++) {
+        printf("Routes from %d\n", cities[k]);
+        for (u = 0; u < N; u++) {
+            long hop = routeHop(cities[k], u);
+            if (hop >= 0)
+                printf("%d: %d\n", u, adjacency[rowStart[cities[k]] + hop]);
+        }
+    }
+    reportDeadline("the rows of the sources not searched yet are empty, and -r does not use the table");
+    if (cancelled) {
+        free(routeTable);
+        routeTable = NULL;
+    }
+
+    free(cities);
+    free(job);
+    free(thread);
 }
 
-// Function to allocate memory for a matrix and initialize it to zeros
-int** createMatrix() {
-    int i;
-    int **matrix = (int **)malloc(N * sizeof(int *));
-    for (i = 0; i < N; i++) {
-        matrix[i] = (int *)calloc(N, sizeof(int));
+// Function to clear a row of the reach semiring
+void reachClear(void *row, int count) {
+    memset(row, 0, ((size_t)count + 63) / 64 * 8);
+}
+
+// Function to add a connection to a row of the reach semiring
+void reachLink(void *row, int city, int cost) {
+    (void)cost;
+    ((uint64_t *)row)[city / 64] |= (uint64_t)1 << (city % 64);
+}
+
+// Function to print a cell of the reach semiring
+void reachPrint(const void *row, int city) {
+    printf("%d", (int)((((const uint64_t *)row)[city / 64] >> (city % 64)) & 1));
+}
+
+// Function to clear a row of the hops semiring
+void hopsClear(void *row, int count) {
+    int j;
+    for (j = 0; j < count; j++)
+        ((int *)row)[j] = HOPS_NONE;
+}
+
+// Function to add a connection to a row of the hops semiring
+void hopsLink(void *row, int city, int cost) {
+    (void)cost;
+    ((int *)row)[city] = 1;
+}
+
+// Function to print a cell of the hops semiring
+void hopsPrint(const void *row, int city) {
+    int hops = ((const int *)row)[city];
+    if (hops >= HOPS_NONE)
+        printf("-");
+    else
+        printf("%d", hops);
+}
+
+// Function to clear a row of the cost semiring
+void costClear(void *row, int count) {
+    int j;
+    for (j = 0; j < count; j++)
+        ((long long *)row)[j] = COST_NONE;
+}
+
+// Function to add a connection to a row of the cost semiring
+void costLink(void *row, int city, int cost) {
+    long long *cell = (long long *)row + city;
+    if (cost < *cell)
+        *cell = cost;
+}
+
+// Function to print a cell of the cost semiring
+void costPrint(const void *row, int city) {
+    long long cost = ((const long long *)row)[city];
+    if (cost >= COST_NONE)
+        printf("-");
+    else
+        printf("%lld", cost);
+}
+
+// A cell of the count semiring
+typedef struct {
+    long long cost; // The cost of the cheapest routes, COST_NONE for none
+    unsigned long long routes; // The number of cheapest routes
+} RouteCount;
+
+// Function to clear a row of the count semiring
+void countClear(void *row, int count) {
+    int j;
+    for (j = 0; j < count; j++) {
+        ((RouteCount *)row)[j].cost = COST_NONE;
+        ((RouteCount *)row)[j].routes = 0;
     }
-    return matrix;
 }
 
-// Function that frees a matrix
-void freeMatrix(int **matrix) {
-    int i;
-    for (i = 0; i < N; i++) {
-        free(matrix[i]);
+// Function to add a connection to a row of the count semiring; parallel connections are separate routes
+void countLink(void *row, int city, int cost) {
+    RouteCount *cell = (RouteCount *)row + city;
+    if (cost < cell->cost) {
+        cell->cost = cost;
+        cell->routes = 1;
+    }
+    else if (cost == cell->cost && cell->routes < ULLONG_MAX) {
+        cell->routes++;
     }
-    free(matrix);
 }
 
-void readAdjacencyMatrix(FILE *inputFile) {
-    if (fscanf(inputFile, "%d", &N) != 1) {
-        fprintf(stderr, "Error: Failed to read the number of cities from the input file.\n");
-        exit(EXIT_FAILURE);
+// Function to print a cell of the count semiring
+void countPrint(const void *row, int city) {
+    printf("%llu", ((const RouteCount *)row)[city].routes);
+}
+
+void reachBlock(const ApspBlock *block, int j0, int j1) {
+    int first = j0 / 64, last = (j1 + 63) / 64, i, k, x;
+
+    for (k = block->k0; k < block->k1; k++) {
+        const uint64_t *next = (const uint64_t *)(block->next + (size_t)(k - block->k0) * block->stride);
+        int column = k - block->viaFirst;
+        for (i = 0; i < block->count; i++) {
+            uint64_t *row = (uint64_t *)(block->rows + (size_t)i * block->stride);
+            const uint64_t *via = (const uint64_t *)(block->via + (size_t)i * block->viaStride);
+            if ((via[column / 64] >> (column % 64)) & 1) {
+                for (x = first; x < last; x++)
+                    row[x] |= next[x];
+            }
+        }
     }
+}
 
-    // Create a dynamic 2D array to store the adjacency matrix
-    cityMatrix = createMatrix();
+void hopsBlock(const ApspBlock *block, int j0, int j1) {
+    int i, k, j;
 
-    int i,j;
-    // Read the adjacency matrix from the input file
-    for (i = 0; i < N; i++) {
-        for (j = 0; j < N; j++) {
-            if (fscanf(inputFile, "%d", &cityMatrix[i][j]) != 1) {
-                fprintf(stderr, "Error: Failed to read the adjacency matrix from the input file.\n");
-                exit(EXIT_FAILURE);
+    for (k = block->k0; k < block->k1; k++) {
+        const int *next = (const int *)(block->next + (size_t)(k - block->k0) * block->stride);
+        for (i = 0; i < block->count; i++) {
+            int *row = (int *)(block->rows + (size_t)i * block->stride);
+            int via = ((const int *)(block->via + (size_t)i * block->viaStride))[k - block->viaFirst];
+            if (via >= HOPS_NONE)
+                continue;
+            for (j = j0; j < j1; j++) {
+                int hops = via + next[j];
+                row[j] = hops < row[j] ? hops : row[j];
             }
         }
     }
 }
 
-int findPath( int source, int destination, int *visited, int *path, int pathIndex) {
-    // Mark the current city as visited
-    visited[source] = 1;
-    path[pathIndex] = source;
-    pathIndex++;
-    int i;
+void costBlock(const ApspBlock *block, int j0, int j1) {
+    int i, k, j;
 
-    // If the destination city is reached, print the path
-    if (source == destination) {
-        printf("Yes Path Exists!\n");
-        for (i = 0; i < pathIndex; i++) {
-            printf("%d", path[i]);
-            if (i < pathIndex - 1) {
-                printf("=>");
+    for (k = block->k0; k < block->k1; k++) {
+        const long long *next = (const long long *)(block->next + (size_t)(k - block->k0) * block->stride);
+        for (i = 0; i < block->count; i++) {
+            long long *row = (long long *)(block->rows + (size_t)i * block->stride);
+            long long via = ((const long long *)(block->via + (size_t)i * block->viaStride))[k - block->viaFirst];
+            if (via >= COST_NONE)
+                continue;
+            for (j = j0; j < j1; j++) {
+                long long cost = via + next[j];
+                row[j] = cost < row[j] ? cost : row[j];
             }
         }
-        printf("\n");
-        return 1;
     }
+}
 
-     // Recur for all adjacent unvisited cities
-     for (i = 0; i < N; i++) {
-        if (!visited[i] && (cityMatrix[source][i])){
-            if(findPath(i, destination, visited, path, pathIndex))
-                return 1;
-            
+unsigned long long multiplyRoutes(unsigned long long a, unsigned long long b) {
+#if defined(__GNUC__)
+    unsigned long long product;
+    return __builtin_mul_overflow(a, b, &product) ? ULLONG_MAX : product;
+#else
+    return a != 0 && b > ULLONG_MAX / a ? ULLONG_MAX : a * b;
+#endif
+}
+
+unsigned long long addRoutes(unsigned long long a, unsigned long long b) {
+#if defined(__GNUC__)
+    unsigned long long sum;
+    return __builtin_add_overflow(a, b, &sum) ? ULLONG_MAX : sum;
+#else
+    unsigned long long sum = a + b;
+    return sum < b ? ULLONG_MAX : sum;
+#endif
+}
+
+void countBlock(const ApspBlock *block, int j0, int j1) {
+    int i, k, j;
+
+    for (k = block->k0; k < block->k1; k++) {
+        const RouteCount *next = (const RouteCount *)(block->next + (size_t)(k - block->k0) * block->stride);
+        for (i = 0; i < block->count; i++) {
+            RouteCount *row = (RouteCount *)(block->rows + (size_t)i * block->stride);
+            RouteCount via = ((const RouteCount *)(block->via + (size_t)i * block->viaStride))[k - block->viaFirst];
+            if (via.cost >= COST_NONE)
+                continue;
+            for (j = j0; j < j1; j++) {
+                long long cost = via.cost + next[j].cost;
+                if (cost > row[j].cost)
+                    continue;
+                unsigned long long routes = multiplyRoutes(via.routes, next[j].routes);
+                if (cost < row[j].cost) {
+                    row[j].cost = cost;
+                    row[j].routes = routes;
+                }
+                else {
+                    row[j].routes = addRoutes(row[j].routes, routes);
+                }
+            }
         }
     }
+}
 
-    // Backtrack: Unmark the current city as visited
-    visited[source] = 0;
-    return 0;
+// The semirings of --apsp
+const Semiring semirings[] = {
+    {"reach", 0, reachClear, reachLink, reachBlock, reachPrint},
+    {"hops", sizeof(int), hopsClear, hopsLink, hopsBlock, hopsPrint},
+    {"cost", sizeof(long long), costClear, costLink, costBlock, costPrint},
+    {"count", sizeof(RouteCount), countClear, countLink, countBlock, countPrint},
+};
+
+// Function to find the bytes of the cells of the given number of columns, starting at a whole block
+size_t semiringBytes(const Semiring *ring, int columns) {
+    return ring->cellBytes == 0 ? ((size_t)columns + 63) / 64 * 8 : (size_t)columns * ring->cellBytes;
 }
 
+void *apspThread(void *arg) {
+    ApspJob *job = (ApspJob *)arg;
+    const Semiring *ring = job->ring;
+    size_t viaStride = semiringBytes(ring, APSP_BLOCK);
+    unsigned char *via = (unsigned char *)malloc(APSP_BLOCK * viaStride);
+    ApspBlock block;
+    int i0, i, j0;
 
-void implementI (char **filename) {
-    *filename = optarg;
-    
-     // Open the input file for reading
-    FILE *inputFile = fopen(*filename, "r");
-    
-    if (inputFile == NULL) {
-        fprintf(stderr, "Error: Unable to open the input file for reading.\n");
+    if (via == NULL) {
+        fprintf(stderr, "Error: Not enough memory for the all pairs engine.\n");
         exit(EXIT_FAILURE);
     }
+    block.stride = job->stride;
+    block.via = via;
+    block.viaStride = viaStride;
+    block.viaFirst = job->k0;
+    block.next = job->matrix + (size_t)job->k0 * job->stride;
+    block.k0 = job->k0;
+    block.k1 = job->k1;
 
-    readAdjacencyMatrix(inputFile);
-    
-    // Close the input file
-    fclose(inputFile);
-
-    int i,j;
-    // Print the adjacency matrix
-    printf("Neighbor table\n");
-    for (i = 0; i < N; i++) {
-        for (j = 0; j < N; j++) {
-            printf("%d ", cityMatrix[i][j]);
-        }
-        printf("\n");
+    for (i0 = job->thread * APSP_BLOCK; i0 < N; i0 += job->threads * APSP_BLOCK) {
+        if (i0 == job->k0)
+            continue;
+        block.rows = job->matrix + (size_t)i0 * job->stride;
+        block.count = i0 + APSP_BLOCK < N ? APSP_BLOCK : N - i0;
+        for (i = 0; i < block.count; i++)
+            memcpy(via + i * viaStride, block.rows + (size_t)i * job->stride + semiringBytes(ring, job->k0),
+                   semiringBytes(ring, job->k1 - job->k0));
+        for (j0 = 0; j0 < N; j0 += APSP_BLOCK)
+            ring->block(&block, j0, j0 + APSP_BLOCK < N ? j0 + APSP_BLOCK : N);
     }
-    printf("\n");
 
-    // Free the dynamically allocated memory for the adjacency matrix
-    freeMatrix(cityMatrix);
+    free(via);
+    return NULL;
 }
 
+int closeSemiring(const Semiring *ring, unsigned char *matrix, size_t stride) {
+    long processors = sysconf(_SC_NPROCESSORS_ONLN);
+    int threads = processors > 0 ? (int)processors : 1;
+    int blocks = (N + APSP_BLOCK - 1) / APSP_BLOCK, k0, j0, t;
 
-void implementR (char **filename) {
-    int sourceCity = -1, destinationCity = -1;
-
-    // sscanf(optarg, "%d,%d", &sourceCity, &destinationCity);
-    if (sscanf(optarg, "%d,%d", &sourceCity, &destinationCity) != 2) {
-        fprintf(stderr, "Invalid source and destination cities: %s\n", optarg);
+    if (threads > blocks)
+        threads = blocks > 0 ? blocks : 1;
+    ApspJob *job = (ApspJob *)malloc(threads * sizeof(ApspJob));
+    pthread_t *thread = (pthread_t *)malloc(threads * sizeof(pthread_t));
+    unsigned char *saved = (unsigned char *)malloc(APSP_BLOCK * stride + 1); // The old rows of the step
+    if (job == NULL || thread == NULL || saved == NULL) {
+        fprintf(stderr, "Error: Not enough memory for the all pairs engine.\n");
         exit(EXIT_FAILURE);
     }
 
-    // Open the input file for reading
-    FILE *inputFile = fopen(*filename, "r");
-    readAdjacencyMatrix(inputFile);
+    for (k0 = 0; k0 < N && !deadlinePassed(); k0 += APSP_BLOCK) {
+        int k1 = k0 + APSP_BLOCK < N ? k0 + APSP_BLOCK : N;
+        ApspBlock block;
 
-    int *visited = (int *)calloc(N, sizeof(int));
-    int *path = (int *)malloc(N * sizeof(int));
-    int pathIndex = 0;
+        // Floyd-Warshall on the block on the diagonal, in place
+        block.rows = matrix + (size_t)k0 * stride;
+        block.stride = stride;
+        block.count = k1 - k0;
+        block.via = block.rows;
+        block.viaStride = stride;
+        block.viaFirst = 0;
+        block.next = block.rows;
+        block.k0 = k0;
+        block.k1 = k1;
+        ring->block(&block, k0, k1);
 
-    if (!findPath(sourceCity, destinationCity, visited, path, pathIndex)) 
-        printf("No Path Exists!\n");
+        // The rest of the rows of the block, joining the closed block with their old cells
+        memcpy(saved, block.rows, (size_t)(k1 - k0) * stride);
+        block.next = saved;
+        for (j0 = 0; j0 < N; j0 += APSP_BLOCK) {
+            if (j0 != k0)
+                ring->block(&block, j0, j0 + APSP_BLOCK < N ? j0 + APSP_BLOCK : N);
+        }
 
-    free(visited);
-    free(path);
-}
+        for (t = 0; t < threads; t++) {
+            job[t].ring = ring;
+            job[t].matrix = matrix;
+            job[t].stride = stride;
+            job[t].k0 = k0;
+            job[t].k1 = k1;
+            job[t].thread = t;
+            job[t].threads = threads;
+            if (pthread_create(&thread[t], NULL, apspThread, &job[t]) != 0) {
+                fprintf(stderr, "Error: Unable to start the thread for the all pairs matrix.\n");
+                exit(EXIT_FAILURE);
+            }
+        }
+        for (t = 0; t < threads; t++)
+            pthread_join(thread[t], NULL);
+    }
 
-void implementP (char **filename) {
+    free(job);
+    free(thread);
+    free(saved);
+    return k0 >= N;
+}
 
-    // Open the input file for reading
-    FILE *inputFile = fopen(*filename, "r");
-    readAdjacencyMatrix(inputFile);
+void implementApsp (char **filename, const char *name) {
+    const Semiring *ring = NULL;
+    size_t k;
+    long e;
+    int u, v;
 
-    // Calculate the transitive closure
-    printf("R* table\n");
-    calculateTransitiveClosure(cityMatrix, NULL, 0);
-}
+    for (k = 0; k < sizeof(semirings) / sizeof(semirings[0]); k++) {
+        if (strcmp(name, semirings[k].name) == 0)
+            ring = &semirings[k];
+    }
+    if (ring == NULL) {
+        fprintf(stderr, "Invalid semiring: %s (reach, hops, cost or count)\n", name);
+        exit(EXIT_FAILURE);
+    }
 
-void implementO (char **filename){
+    loadGraph(*filename);
 
-    char *outputfile = (char *)malloc(strlen(*filename) + 5); // 5 = length of "out-" plus null terminator
-    strcpy(outputfile, "out-");
-    strcat(outputfile, *filename);
-   
-    FILE *file = fopen(outputfile, "w+");
+    // Cheapest routes need costs that never make a route cheaper by going around a cycle
+    int costs = weight != NULL && !hopsOnly && ring->block != hopsBlock && ring->block != reachBlock;
+    if (costs) {
+        for (e = 0; e < edgeCount; e++) {
+            if (weight[e] < (ring->block == countBlock ? 1 : 0)) {
+                fprintf(stderr, "Error: A connection has a cost below %d, which --apsp %s does not allow.\n",
+                        ring->block == countBlock ? 1 : 0, name);
+                exit(EXIT_FAILURE);
+            }
+        }
+    }
 
-    if (file == NULL){
-        fprintf(stderr, "Error opening the output file \n");
+    size_t stride = semiringBytes(ring, N);
+    size_t bytes = (size_t)N * stride;
+    checkMemory(bytes, "The all pairs matrix");
+    unsigned char *matrix = (unsigned char *)malloc(bytes + 1);
+    if (matrix == NULL) {
+        fprintf(stderr, "Error: Not enough memory for the all pairs matrix (%zu bytes).\n", bytes);
         exit(EXIT_FAILURE);
     }
+    for (u = 0; u < N; u++) {
+        ring->clear(matrix + u * stride, N);
+        for (e = rowStart[u]; e < rowStart[u + 1]; e++)
+            ring->link(matrix + u * stride, adjacency[e], costs ? weight[e] : 1);
+    }
 
-    // Open the input file for reading
-    FILE *inputFile = fopen(*filename, "r");
-    readAdjacencyMatrix(inputFile);
+    startDeadline();
+    if (closeSemiring(ring, matrix, stride)) {
+        printf("All pairs %s\n", name);
+        for (u = 0; u < N; u++) {
+            for (v = 0; v < N; v++) {
+                if (v > 0)
+                    printf(" ");
+                ring->print(matrix + u * stride, v);
+            }
+            printf("\n");
+        }
+    }
+    reportDeadline("the all pairs matrix was not finished and is not printed");
 
-    fprintf(file, "R* table\n");
-    calculateTransitiveClosure(cityMatrix, file, 1);
+    free(matrix);
+}
 
-    fclose(file);
-    printf("Saving %s...\n", outputfile);
+void startQuery(Query *query, long index, int source, int destination) {
+    query->index = index;
+    query->destination = destination;
+    query->stage = QUERY_POP;
+    query->level = 0;
+    query->queue[0] = source;
+    query->head = 0;
+    query->tail = 1;
+    query->levelEnd = 1;
+    query->visited[source / 64] |= (uint64_t)1 << (source % 64);
 }
 
+int stepQuery(Query *query, int *answer) {
+    long e;
 
-// Function to calculate the transitive closure
-void calculateTransitiveClosure(int **cityMatrix, FILE *outputFile, int printToFile) {
+    switch (query->stage) {
+        case QUERY_POP:
+            if (query->head == query->tail) {
+                *answer = -1;
+                return 1;
+            }
+            // The cities of a level are all expanded before those of the next one
+            if (query->head == query->levelEnd) {
+                query->level++;
+                query->levelEnd = query->tail;
+            }
+            query->city = query->queue[query->head++];
+            PREFETCH(&rowStart[query->city]);
+            query->stage = QUERY_ROW;
+            return 0;
+        case QUERY_ROW:
+            query->edge = rowStart[query->city];
+            query->edgeEnd = rowStart[query->city + 1];
+            PREFETCH(&adjacency[query->edge]);
+            // With a single query there is nothing to run while the marks load
+            query->stage = queryGroup > 1 ? QUERY_MARK : QUERY_SCAN;
+            return 0;
+        case QUERY_MARK:
+            for (e = query->edge; e < query->edgeEnd; e++)
+                PREFETCH(&query->visited[adjacency[e] / 64]);
+            query->stage = QUERY_SCAN;
+            return 0;
+        default:
+            for (e = query->edge; e < query->edgeEnd; e++) {
+                int w = adjacency[e];
+                if (w == query->destination) {
+                    *answer = query->level + 1;
+                    return 1;
+                }
+                if (query->visited[w / 64] & ((uint64_t)1 << (w % 64)))
+                    continue;
+                query->visited[w / 64] |= (uint64_t)1 << (w % 64);
+                if (query->tail == query->capacity) {
+                    query->capacity *= 2;
+                    query->queue = (int *)realloc(query->queue, query->capacity * sizeof(int));
+                    if (query->queue == NULL) {
+                        fprintf(stderr, "Error: Not enough memory for the queries.\n");
+                        exit(EXIT_FAILURE);
+                    }
+                }
+                query->queue[query->tail++] = w;
+            }
+            query->stage = QUERY_POP;
+            return 0;
+    }
+}
 
-     // Create a new matrix for the transitive closure (initialize it as a copy of the adjacency matrix)
-    int** transitiveClosure = createMatrix();
-   
-    int i,j;
-    for (i = 0; i < N; i++) {
-        for (j = 0; j < N; j++) {
-            transitiveClosure[i][j] = cityMatrix[i][j];
+void *queryThread(void *arg) {
+    QueryJob *job = (QueryJob *)arg;
+    size_t words = ((size_t)N + 63) / 64;
+    Query *slot = (Query *)calloc(queryGroup, sizeof(Query));
+    long next = job->thread, steps = 0, i;
+    int active = 0, s, answer;
+
+    if (slot == NULL) {
+        fprintf(stderr, "Error: Not enough memory for the queries.\n");
+        exit(EXIT_FAILURE);
+    }
+    for (s = 0; s < queryGroup; s++) {
+        slot[s].index = -1;
+        slot[s].capacity = 1024;
+        slot[s].queue = (int *)malloc(slot[s].capacity * sizeof(int));
+        slot[s].visited = (uint64_t *)calloc(words + 1, sizeof(uint64_t));
+        if (slot[s].queue == NULL || slot[s].visited == NULL) {
+            fprintf(stderr, "Error: Not enough memory for the queries.\n");
+            exit(EXIT_FAILURE);
         }
     }
 
-    int u,w,v;
-    // Print the transitive closure after initialization
-    for (u = 0; u < N; u++) {
-        for (w = 0; w < N; w++) {
-            if (transitiveClosure[u][w] == 1) {
-                if (printToFile)
-                    fprintf(outputFile, "%d -> %d\n", u, w);
-                else
-                    printf("%d -> %d\n", u, w);
+    do {
+        // A free slot takes the next query; a query from a city to itself needs no search
+        for (s = 0; s < queryGroup; s++) {
+            while (slot[s].index < 0 && next < job->count) {
+                if (job->sources[next] == job->destinations[next]) {
+                    job->answers[next] = 0;
+                }
+                else {
+                    startQuery(&slot[s], next, job->sources[next], job->destinations[next]);
+                    active++;
+                }
+                next += job->threads;
             }
         }
+
+        // A step of every query in turn, each while the loads of the others are in flight
+        for (s = 0; s < queryGroup; s++) {
+            if (slot[s].index < 0 || !stepQuery(&slot[s], &answer))
+                continue;
+            job->answers[slot[s].index] = answer;
+            for (i = 0; i < slot[s].tail; i++)
+                slot[s].visited[slot[s].queue[i] / 64] = 0;
+            slot[s].index = -1;
+            active--;
+        }
+    } while ((active > 0 || next < job->count) && ((++steps & 0x3FF) != 0 || !deadlinePassed()));
+
+    for (s = 0; s < queryGroup; s++) {
+        free(slot[s].queue);
+        free(slot[s].visited);
     }
+    free(slot);
+    return NULL;
+}
 
-    int **previous = createMatrix();
+void implementQueries (char **filename, const char *queries) {
+    loadGraph(*filename);
 
-    int repeat = 1; // A flag to check for changes
-    while (repeat) {
-        repeat = 0; // Reset the flag
+    FILE *file = fopen(queries, "r");
+    if (file == NULL) {
+        fprintf(stderr, "Error opening the queries file %s\n", queries);
+        exit(EXIT_FAILURE);
+    }
 
-        // Copy the current transitive closure into previous
-        for (u = 0; u < N; u++) {
-            for (w = 0; w < N; w++) {
-                previous[u][w] = transitiveClosure[u][w];
+    long count = 0, capacity = 1024, line = 0, i;
+    int *sources = (int *)malloc(capacity * sizeof(int));
+    int *destinations = (int *)malloc(capacity * sizeof(int));
+    char text[256];
+    if (sources == NULL || destinations == NULL) {
+        fprintf(stderr, "Error: Not enough memory for the queries.\n");
+        exit(EXIT_FAILURE);
+    }
+    while (fgets(text, sizeof(text), file) != NULL) {
+        int u, v;
+        line++;
+        if (strspn(text, " \t\r\n") == strlen(text))
+            continue;
+        if ((sscanf(text, "%d %d", &u, &v) != 2 && sscanf(text, "%d,%d", &u, &v) != 2) ||
+            u < 0 || u >= N || v < 0 || v >= N) {
+            fprintf(stderr, "Error: Invalid query on line %ld of %s\n", line, queries);
+            exit(EXIT_FAILURE);
+        }
+        if (count == capacity) {
+            capacity *= 2;
+            sources = (int *)realloc(sources, capacity * sizeof(int));
+            destinations = (int *)realloc(destinations, capacity * sizeof(int));
+            if (sources == NULL || destinations == NULL) {
+                fprintf(stderr, "Error: Not enough memory for the queries.\n");
+                exit(EXIT_FAILURE);
             }
         }
+        sources[count] = u;
+        destinations[count] = v;
+        count++;
+    }
+    fclose(file);
 
-        for (u = 0; u < N; u++) {
-            for (v = 0; v < N; v++) {
-                if (previous[u][v]) {
-                    for (w = 0; w < N; w++) {
-                        if (cityMatrix[v][w] && !transitiveClosure[u][w] && u != w) {
-                            transitiveClosure[u][w] = 1;
-                            repeat = 1; // Set the flag to indicate a change
-
-                            if (printToFile)
-                                // Print the newly added connection
-                                fprintf(outputFile, "%d -> %d\n", u, w);
-                            else
-                                printf("%d -> %d\n", u, w);
+    long processors = sysconf(_SC_NPROCESSORS_ONLN);
+    int threads = processors > 0 ? (int)processors : 1, k;
+    checkMemory((size_t)threads * queryGroup * (((size_t)N + 63) / 64 * 8 + 1024 * sizeof(int)), "The queries");
+    int *answers = (int *)malloc((count + 1) * sizeof(int));
+    QueryJob *job = (QueryJob *)malloc(threads * sizeof(QueryJob));
+    pthread_t *thread = (pthread_t *)malloc(threads * sizeof(pthread_t));
+    if (answers == NULL || job == NULL || thread == NULL) {
+        fprintf(stderr, "Error: Not enough memory for the queries.\n");
+        exit(EXIT_FAILURE);
+    }
+    for (i = 0; i < count; i++)
+        answers[i] = -2;
 
-                        }
-                    }
-                }
-            }
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    startDeadline();
+    for (k = 0; k < threads; k++) {
+        job[k].thread = k;
+        job[k].threads = threads;
+        job[k].count = count;
+        job[k].sources = sources;
+        job[k].destinations = destinations;
+        job[k].answers = answers;
+        if (pthread_create(&thread[k], NULL, queryThread, &job[k]) != 0) {
+            fprintf(stderr, "Error: Unable to start the thread for the queries.\n");
+            exit(EXIT_FAILURE);
         }
     }
+    for (k = 0; k < threads; k++)
+        pthread_join(thread[k], NULL);
+    clock_gettime(CLOCK_MONOTONIC, &end);
 
-    // Free dynamically allocated memory
-    freeMatrix(transitiveClosure);
-    freeMatrix(previous);
+    printf("Queries\n");
+    for (i = 0; i < count; i++) {
+        if (answers[i] == -1)
+            printf("%d %d: none\n", sources[i], destinations[i]);
+        else if (answers[i] >= 0)
+            printf("%d %d: %d\n", sources[i], destinations[i], answers[i]);
+    }
+    if (statsOutput) {
+        double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+        fprintf(stderr, "Queries: %ld in %.3f seconds (%.0f per second), %d interleaved on each of %d threads\n",
+                count, seconds, seconds > 0 ? count / seconds : 0.0, queryGroup, threads);
+    }
+    reportDeadline("the queries not answered are missing");
+
+    free(sources);
+    free(destinations);
+    free(answers);
+    free(job);
+    free(thread);
 }
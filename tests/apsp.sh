@@ -0,0 +1,38 @@
+#!/bin/sh
+# Checks --apsp count across the blocks of the all pairs engine: on 70 cities, more than one block,
+# with connections i -> i+1 of cost 1 and i -> i+2 of cost 2, every route from i to j costs j - i, so
+# the number of cheapest routes is the Fibonacci number F(j - i + 1).
+# Run from the top of the repository: sh tests/apsp.sh
+set -e
+
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT
+
+gcc cityLink.c -std=c99 -pthread -o "$work/cityLink" -lm
+
+awk 'BEGIN {
+    n = 70
+    print n, "weighted"
+    for (i = 0; i < n - 1; i++) print i, i + 1, 1
+    for (i = 0; i < n - 2; i++) print i, i + 2, 2
+}' > "$work/ladder.txt"
+
+awk 'BEGIN {
+    n = 70
+    f[1] = 1; f[2] = 1
+    for (k = 3; k <= n; k++) f[k] = f[k - 1] + f[k - 2]
+    print "All pairs count"
+    for (i = 0; i < n; i++) {
+        line = ""
+        for (j = 0; j < n; j++) line = line (j > 0 ? " " : "") (j > i ? sprintf("%.0f", f[j - i + 1]) : "0")
+        print line
+    }
+}' > "$work/expected.txt"
+
+(cd "$work" && ./cityLink -i ladder.txt --apsp count) | sed -n '/^All pairs count$/,$p' > "$work/count.txt"
+if cmp -s "$work/count.txt" "$work/expected.txt"; then
+    echo "All pairs counts agree"
+else
+    echo "FAIL: --apsp count differs from the Fibonacci numbers"
+    exit 1
+fi
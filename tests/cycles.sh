@@ -0,0 +1,47 @@
+#!/bin/sh
+# Checks the shortest cycles of --cycles, by cost and with --hops, on more than 64 cities.
+# Run from the top of the repository: sh tests/cycles.sh
+set -e
+
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT
+
+gcc cityLink.c -std=c99 -pthread -o "$work/cityLink" -lm
+
+awk 'BEGIN {
+    print 70, "weighted"
+    for (i = 0; i < 67; i++) print i, (i + 1) % 67, (i == 66 ? 5 : 1)
+    print 67, 68, 1
+    print 68, 67, 9
+    print 10, 67, 1
+    print 68, 69, 1
+}' > "$work/rings.txt"
+
+# The ring costs 66 + 5 over 67 connections, the pair 1 + 9 over 2
+expect() {
+    awk -v ring="$1" -v pair="$2" -v girth="$3" 'BEGIN {
+        print "Shortest cycles"
+        for (i = 0; i < 67; i++) print i ": " ring
+        print "67: " pair
+        print "68: " pair
+        print "69: none"
+        print "Girth: " girth
+    }'
+}
+
+status=0
+expect 71 10 10 > "$work/cost.txt"
+expect 67 2 2 > "$work/hops.txt"
+(cd "$work" && ./cityLink -i rings.txt --cycles) | sed -n '/^Shortest cycles$/,$p' > "$work/found.txt"
+if ! cmp -s "$work/found.txt" "$work/cost.txt"; then
+    echo "FAIL: --cycles differs from the costs of the cycles"
+    status=1
+fi
+(cd "$work" && ./cityLink -i rings.txt --cycles --hops) | sed -n '/^Shortest cycles$/,$p' > "$work/found.txt"
+if ! cmp -s "$work/found.txt" "$work/hops.txt"; then
+    echo "FAIL: --cycles --hops differs from the lengths of the cycles"
+    status=1
+fi
+
+[ $status -eq 0 ] && echo "All cycles agree"
+exit $status
@@ -0,0 +1,36 @@
+#!/bin/sh
+# Checks that --encode bits and hex refuse a network with connection costs, read as a matrix or
+# as a weighted edge list, and that the encodings which can hold costs read back to the same network.
+# Run from the top of the repository: sh tests/encode.sh
+set -e
+
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT
+
+gcc cityLink.c -std=c99 -pthread -o "$work/cityLink" -lm
+
+printf '4 weighted\n0 1 5\n1 2 3\n2 3 12\n' > "$work/edges.txt"
+printf '4\n0 5 0 0\n0 0 3 0\n0 0 0 12\n0 0 0 0\n' > "$work/matrix.txt"
+
+status=0
+for input in edges.txt matrix.txt; do
+    for encoding in bits hex; do
+        if (cd "$work" && ./cityLink -i "$input" --encode "$encoding" > /dev/null 2>&1); then
+            echo "FAIL: $input: --encode $encoding accepted connection costs"
+            status=1
+        fi
+    done
+    for encoding in plain rle weighted; do
+        # Both are written back as weighted edge lists, which list the same connections and costs
+        (cd "$work" && ./cityLink -i "$input" --encode "$encoding" > /dev/null)
+        (cd "$work" && ./cityLink -i "$input.$encoding" --encode weighted > /dev/null)
+        (cd "$work" && ./cityLink -i "$input" --encode weighted > /dev/null)
+        if ! cmp -s "$work/$input.weighted" "$work/$input.$encoding.weighted"; then
+            echo "FAIL: $input: --encode $encoding does not read back to the same network"
+            status=1
+        fi
+    done
+done
+
+[ $status -eq 0 ] && echo "All encodings agree"
+exit $status
@@ -0,0 +1,36 @@
+#!/bin/sh
+# Checks that every closure engine lists the same R* pairs for a network with connection costs.
+# Run from the top of the repository: sh tests/engines.sh
+set -e
+
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT
+
+gcc cityLink.c -std=c99 -pthread -o "$work/cityLink" -lm
+
+# Cells other than 0 and 1 are costs, which still count as connections
+printf '3\n0 2 0\n0 0 1\n0 0 0\n' > "$work/weighted.txt"
+printf '5\n0 3 0 0 0\n0 0 7 0 1\n2 0 0 0 0\n0 0 0 0 4\n0 0 0 9 0\n' > "$work/cycles.txt"
+
+status=0
+for input in weighted.txt cycles.txt; do
+    expected=""
+    for engine in rounds bitset bfs chains; do
+        (cd "$work" && ./cityLink -i "$input" --engine "$engine" -o > /dev/null)
+        pairs=$(tail -n +2 "$work/out-$input" | sort)
+        if [ -z "$expected" ]; then
+            expected=$pairs
+        elif [ "$pairs" != "$expected" ]; then
+            echo "FAIL: $input: the $engine engine differs from the rounds engine"
+            status=1
+        fi
+    done
+    # The first input has the direct connection 0 -> 1 of cost 2
+    if [ "$input" = weighted.txt ] && ! echo "$expected" | grep -qx "0 -> 1"; then
+        echo "FAIL: $input: the connection 0 -> 1 of cost 2 is missing"
+        status=1
+    fi
+done
+
+[ $status -eq 0 ] && echo "All engines agree"
+exit $status
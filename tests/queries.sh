@@ -0,0 +1,27 @@
+#!/bin/sh
+# Checks the answers of --queries, in the order of the file, for several numbers of queries at once.
+# Run from the top of the repository: sh tests/queries.sh
+set -e
+
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT
+
+gcc cityLink.c -std=c99 -pthread -o "$work/cityLink" -lm
+
+# A cycle 0 -> 1 -> 3 -> 4 -> 0 with a second route 0 -> 2 -> 3, and a city without connections
+printf '6 edges\n0 1\n0 2\n1 3\n2 3\n3 4\n4 0\n' > "$work/network.txt"
+printf '0 4\n2 1\n5 0\n3 3\n0 5\n1 1\n' > "$work/queries.txt"
+printf 'Queries\n0 4: 3\n2 1: 4\n5 0: none\n3 3: 0\n0 5: none\n1 1: 0\n' > "$work/answers.txt"
+
+status=0
+for interleave in 1 3 8; do
+    (cd "$work" && ./cityLink -i network.txt --queries queries.txt --interleave "$interleave") \
+        | sed -n '/^Queries$/,$p' > "$work/found.txt"
+    if ! cmp -s "$work/found.txt" "$work/answers.txt"; then
+        echo "FAIL: the answers of --queries with --interleave $interleave differ"
+        status=1
+    fi
+done
+
+[ $status -eq 0 ] && echo "All queries agree"
+exit $status
@@ -0,0 +1,42 @@
+#!/bin/sh
+# Checks the routing table of --routes and the routes -r follows through it.
+# Run from the top of the repository: sh tests/routes.sh
+set -e
+
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT
+
+gcc cityLink.c -std=c99 -pthread -o "$work/cityLink" -lm
+
+# Two routes of two connections from 0 to 3, the first through 1, and a city without connections
+printf '6 edges\n0 1\n0 2\n1 3\n2 3\n3 4\n4 0\n' > "$work/routes.txt"
+printf 'Routes from 0\n1: 1\n2: 2\n3: 1\n4: 1\nRoutes from 3\n0: 4\n1: 4\n2: 4\n4: 4\n' > "$work/tables.txt"
+
+status=0
+(cd "$work" && ./cityLink -i routes.txt --routes=0,3) | sed -n '/^Routes from /,$p' > "$work/found.txt"
+if ! cmp -s "$work/found.txt" "$work/tables.txt"; then
+    echo "FAIL: the tables of --routes=0,3 differ"
+    status=1
+fi
+# "CLRT", 6 cities and 1-byte entries, then 6 x 6 entries
+if [ "$(head -c 4 "$work/out-routes.txt.routes")" != CLRT ] || [ "$(wc -c < "$work/out-routes.txt.routes")" -ne 48 ]; then
+    echo "FAIL: out-routes.txt.routes does not hold a table of 6 x 6 entries of 1 byte"
+    status=1
+fi
+
+check_route() {
+    found=$(cd "$work" && ./cityLink -i routes.txt --routes -r "$1" | tail -n 2)
+    if [ "$found" != "$2" ]; then
+        echo "FAIL: -r $1 after --routes prints \"$found\""
+        status=1
+    fi
+}
+check_route 0,4 "Yes Path Exists!
+0=>1=>3=>4"
+check_route 2,1 "Yes Path Exists!
+2=>3=>4=>0=>1"
+check_route 5,0 "Saving out-routes.txt.routes...
+No Path Exists!"
+
+[ $status -eq 0 ] && echo "All routes agree"
+exit $status